@@ -0,0 +1,138 @@
+#pragma once
+#include "config.hpp"
+#include "blade.hpp"
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <numeric>
+
+// renders the same camera path once per configuration
+// and writes the frame times of every run into a csv file
+
+struct benchmark_config {
+	std::string name;
+	grass_path path = grass_path::tessellation;
+	bool sort = true;
+};
+
+struct benchmark_frame {
+	float frame_time_ms = 0.0f;
+	uint64_t fragment_invocations = 0;
+
+	// read back a few frames late, see frame_stats
+	uint32_t visible_blades = 0;
+	blade_cull_stats cull{};
+};
+
+class benchmark {
+public:
+	benchmark(std::vector<benchmark_config> configs, uint32_t warmup_frames, uint32_t measured_frames)
+		: configs_(std::move(configs)), warmup_frames_(warmup_frames), measured_frames_(measured_frames)
+	{
+		results_.resize(configs_.size());
+	}
+
+	// every configuration the demo can be compared in
+	static std::vector<benchmark_config> default_configs(bool mesh_shaders) {
+		std::vector<benchmark_config> configs = {
+			{ "tessellation", grass_path::tessellation, false },
+			{ "tessellation_sorted", grass_path::tessellation, true },
+			{ "strips", grass_path::strips, false },
+			{ "strips_sorted", grass_path::strips, true }
+		};
+
+		// the task shader culls unsorted blades only
+		if (mesh_shaders) configs.push_back({ "mesh", grass_path::mesh, false });
+
+		return configs;
+	}
+
+public:
+	bool running() const {
+		return current_ < configs_.size();
+	}
+
+	const benchmark_config& config() const {
+		return configs_[current_];
+	}
+
+	// frame within the current run, warmup included, drives the camera path
+	uint32_t frame() const {
+		return frame_;
+	}
+
+	// true when the frame has finished the current run
+	bool record(const benchmark_frame& frame) {
+		if (!running()) return false;
+
+		if (frame_++ >= warmup_frames_)
+			results_[current_].push_back(frame);
+
+		if (frame_ < warmup_frames_ + measured_frames_) return false;
+
+		frame_ = 0;
+		++current_;
+
+		return true;
+	}
+
+	void write_csv(const std::string& path) const {
+		std::ofstream file(path);
+
+		if (!file.is_open()) throw std::runtime_error("failed to open " + path + "!");
+
+		file << "config,path,sort,frames,avg_ms,median_ms,p99_ms,max_ms,avg_fps,avg_fragment_invocations,avg_visible_blades,"
+			"avg_tested,avg_orientation_culled,avg_frustum_culled,avg_distance_culled,avg_card_handover,avg_occlusion_culled,avg_survived\n";
+
+		for (size_t i = 0; i < configs_.size(); ++i) {
+			const auto& frames = results_[i];
+			if (frames.empty()) continue;
+
+			std::vector<float> times(frames.size());
+			std::transform(frames.begin(), frames.end(), times.begin(), [](const benchmark_frame& f) { return f.frame_time_ms; });
+			std::sort(times.begin(), times.end());
+
+			const double total_ms = std::accumulate(times.begin(), times.end(), 0.0);
+			const double average_ms = total_ms / times.size();
+
+			const auto average = [&](auto count) {
+				const double total = std::accumulate(frames.begin(), frames.end(), 0.0,
+					[&](double sum, const benchmark_frame& f) { return sum + count(f); });
+
+				return static_cast<uint64_t>(total / frames.size());
+			};
+
+			file << configs_[i].name << ',' << to_string(configs_[i].path) << ',' << configs_[i].sort << ','
+				<< times.size() << ',' << average_ms << ','
+				<< percentile(times, 0.5) << ',' << percentile(times, 0.99) << ',' << times.back() << ','
+				<< 1000.0 / average_ms << ',' << average([](const benchmark_frame& f) { return f.fragment_invocations; }) << ','
+				<< average([](const benchmark_frame& f) { return f.visible_blades; }) << ','
+				<< average([](const benchmark_frame& f) { return f.cull.tested; }) << ','
+				<< average([](const benchmark_frame& f) { return f.cull.orientation_culled; }) << ','
+				<< average([](const benchmark_frame& f) { return f.cull.frustum_culled; }) << ','
+				<< average([](const benchmark_frame& f) { return f.cull.distance_culled; }) << ','
+				<< average([](const benchmark_frame& f) { return f.cull.card_handover; }) << ','
+				<< average([](const benchmark_frame& f) { return f.cull.occlusion_culled; }) << ','
+				<< average([](const benchmark_frame& f) { return f.cull.survived; }) << '\n';
+		}
+	}
+
+private:
+	// times are sorted
+	static float percentile(const std::vector<float>& times, double p) {
+		const size_t index = static_cast<size_t>(p * (times.size() - 1) + 0.5);
+		return times[std::min(index, times.size() - 1)];
+	}
+
+private:
+	std::vector<benchmark_config> configs_;
+	std::vector<std::vector<benchmark_frame>> results_;
+
+	uint32_t warmup_frames_;
+	uint32_t measured_frames_;
+
+	size_t current_ = 0;
+	uint32_t frame_ = 0;
+};
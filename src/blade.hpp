@@ -1,5 +1,10 @@
+#pragma once
 #include "config.hpp"
 
+#include <glm/packing.hpp>
+
+#include <random>
+
 struct blade_push_constant_data {
 	// vertex shader
 	alignas(16) glm::mat4 model_matrix;
@@ -12,22 +17,101 @@ struct blade_push_constant_data {
 struct blade_compute_push_data {
 	alignas(16) glm::mat4 view_matrix;
 	alignas(16) glm::mat4 projection_matrix;
+	alignas(16) glm::mat4 previous_view_projection; // the camera the Hi-Z pyramid was rendered with
 
 	float		delta_time;
 	float		total_time;
+	float		wind_power;
+	uint32_t	wind_epoch;		// bumped whenever the wind changes, wakes up every blade
+	uint32_t	strip_lods;		// a bit per lod bucket drawn as instanced strips
+
+	alignas(16) glm::vec4 wake_sphere;	// xyz is center, w is radius; w <= 0 wakes nobody
+
+	alignas(8) vk::DeviceAddress buffers;	// blade_buffer_addresses, the push range is full with it
+};
+
+// grass.task and grass.mesh
+struct blade_mesh_push_data {
+	alignas(16) glm::mat4 view_matrix;
+	alignas(16) glm::mat4 projection_matrix;
+	alignas(16) glm::mat4 previous_view_projection;
+
+	alignas(8) vk::DeviceAddress buffers;
 };
 
+struct blade_state {
+	uint32_t rest_frames;	// frames in a row v2 has barely moved
+	uint32_t wind_epoch;	// the wind the blade has settled in
+};
+
+struct blade_awake_list {
+	// the physics pass is dispatched indirectly from here
+	uint32_t group_count_x;
+	uint32_t group_count_y;
+	uint32_t group_count_z;
+
+	uint32_t awake_count;
+	uint32_t asleep_count;
+
+	// followed by awake_count blade indices
+};
+
+// counted by grass.comp per subgroup, all zero with tools::params::CULL_STATS off.
+// the orientation, frustum and distance tests count what they would reject
+struct blade_cull_stats {
+	uint32_t tested;			// blades of visible tiles that reached the tests
+	uint32_t orientation_culled;
+	uint32_t frustum_culled;
+	uint32_t distance_culled;
+	uint32_t card_handover;		// left to the far field cards
+	uint32_t occlusion_culled;
+	uint32_t survived;			// put into a lod bucket
+};
+
+struct blade_sort_push_data {
+	alignas(16) glm::vec4 eye;
+	uint32_t range; // blades per lod range of the culled buffer
+	uint32_t strip_lods;
+
+	alignas(8) vk::DeviceAddress buffers;
+};
+
+// an entry of the tile table, one per slot of the streamed blade pool
+struct grass_tile_slot {
+	uint32_t tile;			// row * tiles_per_row + column of the world tile in the slot
+	uint32_t blade_count;	// 0 while the slot is empty
+	uint32_t visible;		// the tile passed the frustum test this frame
+	uint32_t padding;
+};
+
+// the root in fp32, the rest in half precision, two halves to a uint32_t as packHalf2x16
+// in the shaders puts them. v1 and v2 are kept relative to v0: a blade is only a few units
+// tall, where half precision still resolves about a thousandth, world positions it would not
 struct blade {
-	glm::vec4 v0; // v0.w is direction_angle
-	glm::vec4 v1; // v1.w is height
-	glm::vec4 v2; // v2.w is width
-	glm::vec4 up; // up.w is stiffness
+	glm::vec4 v0;	// v0.w is direction_angle
+	glm::uvec2 v1;	// relative to v0, v1.w is height
+	glm::uvec2 v2;	// relative to v0, v2.w is width
+	glm::uvec2 up;	// up.w is stiffness
 
 public:
-	static constexpr auto binding_description() {
+	static glm::uvec2 pack_half4(const glm::vec4& value) {
+		return { glm::packHalf2x16(glm::vec2(value.x, value.y)), glm::packHalf2x16(glm::vec2(value.z, value.w)) };
+	}
+
+	static glm::vec4 unpack_half4(const glm::uvec2& value) {
+		return { glm::unpackHalf2x16(value.x), glm::unpackHalf2x16(value.y) };
+	}
+
+	// v1 and v2 relative to v0
+	static blade pack(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2, const glm::vec4& up) {
+		return { v0, pack_half4(v1), pack_half4(v2), pack_half4(up) };
+	}
+
+	// per vertex for the tessellated patches, per instance for the strips
+	static constexpr auto binding_description(vk::VertexInputRate input_rate = vk::VertexInputRate::eVertex) {
 		vk::VertexInputBindingDescription binding_description{};
 		binding_description.binding = 0;
-		binding_description.inputRate = vk::VertexInputRate::eVertex;
+		binding_description.inputRate = input_rate;
 		binding_description.stride = sizeof(blade);
 
 		return binding_description;
@@ -40,25 +124,29 @@ public:
 		attribute_description[0].format = vk::Format::eR32G32B32A32Sfloat;
 		attribute_description[0].offset = offsetof(blade, v0);
 
+		// the vertex fetch unpacks the halves, grass.vert adds v0 back to v1 and v2
 		attribute_description[1].binding = 0;
 		attribute_description[1].location = 1;
-		attribute_description[1].format = vk::Format::eR32G32B32A32Sfloat;
+		attribute_description[1].format = vk::Format::eR16G16B16A16Sfloat;
 		attribute_description[1].offset = offsetof(blade, v1);
 
 		attribute_description[2].binding = 0;
 		attribute_description[2].location = 2;
-		attribute_description[2].format = vk::Format::eR32G32B32A32Sfloat;
+		attribute_description[2].format = vk::Format::eR16G16B16A16Sfloat;
 		attribute_description[2].offset = offsetof(blade, v2);
 
 		attribute_description[3].binding = 0;
 		attribute_description[3].location = 3;
-		attribute_description[3].format = vk::Format::eR32G32B32A32Sfloat;
+		attribute_description[3].format = vk::Format::eR16G16B16A16Sfloat;
 		attribute_description[3].offset = offsetof(blade, up);
 
 		return attribute_description;
 	}
 };
 
+// blade_t in the shaders, whose members are no wider than 8 bytes so that std430 packs them as tight
+static_assert(sizeof(blade) == 40);
+
 struct blade_draw_indirect {
 	uint32_t vertex_count;
 	uint32_t instance_count;
@@ -66,8 +154,93 @@ struct blade_draw_indirect {
 	uint32_t first_instance;
 };
 
+enum blade_lod : uint32_t {
+	near_lod,	// full tessellation
+	mid_lod,	// reduced tessellation
+	far_lod,	// triangle strips, no tessellation stages at all
+
+	lod_count
+};
+
+// how the near and mid lods get their geometry, the far one is always a strip
+enum class grass_path : uint32_t {
+	tessellation,	// one patch per blade, expanded by grass.tesc/grass.tese
+	strips,			// one instance per blade, expanded by grass_strip.vert
+	mesh			// culled by grass.task and emitted by grass.mesh, no lod buckets at all
+};
+
+constexpr uint32_t strip_lods(grass_path path) {
+	return path == grass_path::strips ? (1u << near_lod) | (1u << mid_lod) | (1u << far_lod) : (1u << far_lod);
+}
+
+constexpr const char* to_string(grass_path path) {
+	switch (path) {
+	case grass_path::strips:	return "strips";
+	case grass_path::mesh:		return "mesh";
+	default:					return "tessellation";
+	}
+}
+
+// what the cull pass fills in, one bucket of the culled buffer per lod
+struct blade_draw_commands {
+	blade_draw_indirect lods[lod_count];
+	uint32_t draw_counts[lod_count];
+
+	// empty buckets: patches count vertices, strips count instances
+	static blade_draw_commands empty(uint32_t blades_num, uint32_t strip_lods, const uint32_t (&strip_vertices)[lod_count]) {
+		blade_draw_commands commands{};
+
+		for (uint32_t lod = 0; lod < lod_count; ++lod) {
+			if (strip_lods & (1u << lod))
+				commands.lods[lod] = { strip_vertices[lod], 0, 0, lod * blades_num };
+			else
+				commands.lods[lod] = { 0, 1, lod * blades_num, 0 };
+		}
+
+		return commands;
+	}
+};
+
+// a far field stand-in for a patch of blades: a vertical quad
+// textured with blades baked at startup, see grass_card.vert
+struct grass_card {
+	glm::vec4 position; // position.w is the rotation around the up axis
+	glm::vec4 size;		// width and height, zw unused
+
+public:
+	static constexpr auto binding_description() {
+		vk::VertexInputBindingDescription binding_description{};
+		binding_description.binding = 0;
+		binding_description.inputRate = vk::VertexInputRate::eInstance;
+		binding_description.stride = sizeof(grass_card);
+
+		return binding_description;
+	}
+
+	static constexpr auto attribute_descriptions() {
+		std::vector<vk::VertexInputAttributeDescription> attribute_description(2);
+		attribute_description[0].binding = 0;
+		attribute_description[0].location = 0;
+		attribute_description[0].format = vk::Format::eR32G32B32A32Sfloat;
+		attribute_description[0].offset = offsetof(grass_card, position);
+
+		attribute_description[1].binding = 0;
+		attribute_description[1].location = 1;
+		attribute_description[1].format = vk::Format::eR32G32B32A32Sfloat;
+		attribute_description[1].offset = offsetof(grass_card, size);
+
+		return attribute_description;
+	}
+};
+
+struct blade_card_push_data {
+	alignas(16) glm::mat4 view_matrix;
+	alignas(16) glm::mat4 projection_matrix;
+	alignas(16) glm::vec4 eye;
+};
+
 struct grass {
-	static constexpr auto generate_terrain() -> std::vector<blade> {
+	static auto generate_terrain() -> std::vector<blade> {
 		// just a single blade
 		std::vector<blade> blades;
 
@@ -79,12 +252,12 @@ struct grass {
 		glm::vec3 up{ 0.f, 1.f, 0.f };
 		glm::vec3 initial_position{ 0.5, 0.f, 0.0 };
 
-		blade b{
+		blade b = blade::pack(
 			{initial_position, direction_angle},		// v0
-			{initial_position + up * height, height},	// v1
-			{initial_position + up * height, width},	// v2
+			{up * height, height},						// v1
+			{up * height, width},						// v2
 			{up, stiffness}								// up
-		};
+		);
 
 		blades.emplace_back(b);
 
@@ -124,12 +297,12 @@ struct grass {
 			const float stiffness = random_float() * (max_bend - min_bend) + min_bend;
 
 
-			blade b{
+			blade b = blade::pack(
 				{initial_position, direction_angle},        // v0
-				{initial_position + up * height, height},   // v1
-				{initial_position + up * height, width},    // v2
+				{up * height, height},                      // v1
+				{up * height, width},                       // v2
 				{up, stiffness}                             // up
-			};
+			);
 
 			blades[i] = std::move(b);
 		}
@@ -175,12 +348,12 @@ struct grass {
 			const float height = random_float() * (max_height - min_height) + min_height;
 			const float stiffness = random_float() * (max_bend - min_bend) + min_bend;;
 
-			blade b{
+			blade b = blade::pack(
 				{initial_position, direction_angle},		// v0
-				{initial_position + up * height, height},	// v1
-				{initial_position + up * height, width},	// v2
+				{up * height, height},						// v1
+				{up * height, width},						// v2
 				{up, stiffness}								// up
-			};
+			);
 
 			blades[i] = std::move(b); 
 		}
@@ -188,6 +361,81 @@ struct grass {
 		return blades;
 	}
 
+	// the blades of a single tile, the same ones for the same seed, so that a
+	// streamed tile looks no different after it has been evicted and generated again.
+	// safe to call from any thread, unlike the generators above
+	static auto generate_tile(const float tile_x, const float tile_z, const float tile_dim, const unsigned int num_blades, const uint32_t seed) -> std::vector<blade> {
+		const float min_height = 2.5f;
+		const float max_height = 4.f;
+
+		const float min_width = 0.14f;
+		const float max_width = 0.44f;
+
+		const float min_bend = 5.0f;
+		const float max_bend = 10.0f;
+
+		std::minstd_rand engine(seed + 1);
+		std::uniform_real_distribution<float> random(0.0f, 1.0f);
+
+		std::vector<blade> blades(num_blades);
+
+		const glm::vec3 up{ 0.f, 1.f, 0.f };
+
+		for (auto& b : blades) {
+			const float x = tile_x + random(engine) * tile_dim;
+			const float z = tile_z + random(engine) * tile_dim;
+
+			const float direction_angle = random(engine) * 2.f * glm::pi<float>();
+
+			const glm::vec3 initial_position{ x, 0.0f, z };
+
+			const float width = random(engine) * (max_width - min_width) + min_width;
+			const float height = random(engine) * (max_height - min_height) + min_height;
+			const float stiffness = random(engine) * (max_bend - min_bend) + min_bend;
+
+			b = blade::pack(
+				{initial_position, direction_angle},		// v0
+				{up * height, height},						// v1
+				{up * height, width},						// v2
+				{up, stiffness}								// up
+			);
+		}
+
+		return blades;
+	}
+
+	// cards_per_tile cards for every tile of a square field, stored tile after tile
+	// in row-major order so that a row of tiles is a single instance range
+	static auto generate_cards(const float field_dim, const float tile_dim, const unsigned int cards_per_tile,
+		const float card_width, const float card_height) -> std::vector<grass_card> {
+
+		const unsigned int tiles_per_row = static_cast<unsigned int>(field_dim / tile_dim);
+
+		std::vector<grass_card> cards;
+		cards.reserve(tiles_per_row * tiles_per_row * cards_per_tile);
+
+		for (unsigned int row = 0; row < tiles_per_row; ++row) {
+			for (unsigned int column = 0; column < tiles_per_row; ++column) {
+				const float tile_x = column * tile_dim - 0.5f * field_dim;
+				const float tile_z = row * tile_dim - 0.5f * field_dim;
+
+				for (unsigned int i = 0; i < cards_per_tile; ++i) {
+					const float x = tile_x + random_float() * tile_dim;
+					const float z = tile_z + random_float() * tile_dim;
+					const float rotation = random_float() * glm::pi<float>();
+					const float scale = 0.75f + 0.5f * random_float();
+
+					cards.push_back({
+						{ x, 0.0f, z, rotation },
+						{ card_width * scale, card_height * scale, 0.0f, 0.0f }
+					});
+				}
+			}
+		}
+
+		return cards;
+	}
+
 private:
 	static float random_float() {
 		return static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
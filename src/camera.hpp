@@ -6,11 +6,13 @@
 
 #include <limits>
 #include <cassert>
+#include <array>
 
 class camera {
 public:
 	void set_view_direction(const glm::vec3& position, const glm::vec3& direction, const glm::vec3& up = glm::vec3{ .0f, -1.f, .0f }) {
 		view_matrix_ = glm::lookAt(position, direction, up);
+		position_ = position;
 		return;
 	}
 
@@ -23,15 +25,38 @@ public:
 		float radPhi = glm::radians(phi);
 
 		glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), radTheta, glm::vec3(0.0f, 1.0f, 0.0f)) * glm::rotate(glm::mat4(1.0f), radPhi, glm::vec3(1.0f, 0.0f, 0.0f));
-		glm::mat4 final_transform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f)) * rotation * glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.0f, r));
+		const glm::vec3 offset(0.0f, 1.0f, r);
 
-		view_matrix_ = glm::inverse(final_transform);
+		// the camera sits at rotation * offset. the inverse of a rotation is its transpose,
+		// so the view needs no general matrix inverse
+		view_matrix_ = glm::translate(glm::mat4(1.0f), -offset) * glm::transpose(rotation);
+		position_ = glm::vec3(rotation * glm::vec4(offset, 1.0f));
+	}
+
+	// absolute orbit around the origin, in degrees
+	void set_orbit(float theta_degrees, float phi_degrees, float radius) {
+		theta = theta_degrees;
+		phi = phi_degrees;
+		r = radius;
+
+		update(0.0f, 0.0f, 0.0f);
 	}
 
 	static auto get_projection(float aspect_ratio) {
 		return glm::perspective(glm::radians(90.0f), aspect_ratio, 0.1f, 100.0f);
 	}
 
+	// clip space planes of a view projection with 0..1 depth, inside is dot(plane, p) >= 0
+	static std::array<glm::vec4, 6> frustum_planes(const glm::mat4& m) {
+		const auto row = [&](int i) { return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+
+		return {
+			row(3) + row(0), row(3) - row(0),
+			row(3) + row(1), row(3) - row(1),
+			row(2), row(3) - row(2)
+		};
+	}
+
 public:
 	const auto get_projection() const {
 		return projection_matrix_;
@@ -40,11 +65,16 @@ public:
 	const auto get_view() const {
 		return view_matrix_;
 	}
+
+	const auto get_position() const {
+		return position_;
+	}
 private:
 	glm::mat4 projection_matrix_{ 1.f };
 	glm::mat4 view_matrix_{ 1.f };
+	glm::vec3 position_{ 0.f };
 
-	float r; 
-	float theta; 
-	float phi;
+	float r = 1.0f; 
+	float theta = 0.0f; 
+	float phi = 0.0f;
 };
\ No newline at end of file
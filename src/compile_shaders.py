@@ -0,0 +1,69 @@
+# compiles every GLSL shader next to this script into a .spv file of the same name,
+# plus the variants of a few with a define, and embeds them all into shaders_spirv.hpp with embed_spirv.py.
+# run it before building the application, e.g. as a pre-build event, neither the .spv
+# files nor the header are kept in the repository
+#
+#	python compile_shaders.py [compiler]
+#
+# the compiler defaults to glslangValidator, it has to be on the path
+
+import os
+import subprocess
+import sys
+
+STAGES = (".vert", ".tesc", ".tese", ".frag", ".comp", ".task", ".mesh")
+
+# the target of tools::params::SHADER_COMPILER, the one the hot reload compiles for.
+# it has to match the apiVersion of the instance: vulkan1.3 would emit SPIR-V 1.6,
+# which a Vulkan 1.2 instance does not accept. 1.2 still covers the SPIR-V 1.4 of
+# the mesh shaders
+FLAGS = ["-V", "--target-env", "vulkan1.2"]
+
+# compiled once more with a define each, see device_context::shader_variants
+VARIANTS = {
+	"grass_physics.comp": [("grass_physics_fp16.comp.spv", "BLADE_FP16")],
+	"grass.tese": [("grass_fp16.tese.spv", "BLADE_FP16")],
+	"grass.comp": [("grass_stats.comp.spv", "CULL_STATS")],
+}
+
+
+def compile_shader(compiler, source, output, defines=()):
+	command = [compiler, *FLAGS, *defines, source, "-o", output]
+
+	try:
+		result = subprocess.run(command, capture_output=True, text=True)
+	except FileNotFoundError:
+		sys.exit(f"{compiler} is not on the path")
+
+	if result.returncode != 0:
+		sys.exit(f"failed to compile {source}:\n{result.stdout}{result.stderr}")
+
+
+def main():
+	compiler = sys.argv[1] if len(sys.argv) > 1 else "glslangValidator"
+	directory = os.path.dirname(os.path.abspath(__file__))
+
+	sources = sorted(name for name in os.listdir(directory) if name.endswith(STAGES))
+	outputs = []
+
+	for source in sources:
+		path = os.path.join(directory, source)
+
+		outputs.append(path + ".spv")
+		compile_shader(compiler, path, outputs[-1])
+
+		for variant, define in VARIANTS.get(source, []):
+			outputs.append(os.path.join(directory, variant))
+			compile_shader(compiler, path, outputs[-1], ["-D" + define])
+
+	header = os.path.join(directory, "shaders_spirv.hpp")
+	result = subprocess.run([sys.executable, os.path.join(directory, "embed_spirv.py"), header, *outputs])
+
+	if result.returncode != 0:
+		sys.exit("failed to embed the shaders")
+
+	print(f"compiled and embedded {len(outputs)} shaders")
+
+
+if __name__ == "__main__":
+	main()
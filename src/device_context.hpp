@@ -9,12 +9,57 @@
 #include <set>
 #include <fstream>
 #include <sstream>
+#include <numeric>
+#include <cmath>
+#include <string_view>
+#include <unordered_map>
+#include <iomanip>
+#include <filesystem>
+#include <span>
+#include <optional>
+#include <algorithm>
+#include <cstdlib>
 
 #include "vertex.hpp"
 #include "blade.hpp"
+#include "frame_stats.hpp"
+#include "terrain.hpp"
+#include "job_system.hpp"
+#include "embedded_shaders.hpp"
+#include "shader_watcher.hpp"
+#include "workgroup_tuner.hpp"
+#include "dynamic_resolution.hpp"
 
 const char* TEXTURE_PATH = "grass.jpg";
+const char* WORKGROUP_CACHE_PATH = "workgroup_sizes.txt"; // see workgroup_cache
 constexpr size_t MAX_FRAMES_IN_FLIGHT = 2;
+constexpr uint32_t COMPUTE_WORKGROUP_SIZE = 32; // local_size_x of grass.task, and of grass.comp and grass_physics.comp until tuned
+constexpr uint32_t COMPUTE_TIMESTAMPS = 4; // around the physics dispatch, then around the cull dispatch
+constexpr uint32_t SORT_WORKGROUP_SIZE = 64; // local_size_x of grass_sort.comp
+constexpr uint32_t DEPTH_BUCKET_COUNT = 64;
+constexpr uint32_t MAX_BLADE_SHARDS = 8; // max_shards in the shaders
+
+// blade_buffers_t of the grass shaders: every buffer the cull, physics, sort and
+// mesh passes touch, as a pointer. the passes get its own address pushed, so
+// none of them needs a storage buffer descriptor; unused shard entries are 0
+struct blade_buffer_addresses {
+	vk::DeviceAddress blade_shards[MAX_BLADE_SHARDS];
+	vk::DeviceAddress state_shards[MAX_BLADE_SHARDS];
+	vk::DeviceAddress culled;
+	vk::DeviceAddress sorted;
+	vk::DeviceAddress indirect;
+	vk::DeviceAddress awake;
+	vk::DeviceAddress stats;
+	vk::DeviceAddress tiles;
+	vk::DeviceAddress depth_buckets;
+};
+
+// triangle strip vertices per blade instance of every lod
+constexpr uint32_t STRIP_VERTICES[lod_count] = {
+	2 * (tools::params::NEAR_STRIP_SEGMENTS + 1),
+	2 * (tools::params::MID_STRIP_SEGMENTS + 1),
+	2 * (tools::params::FAR_STRIP_SEGMENTS + 1)
+};
 
 struct plane_push_constant {
 	alignas(16) glm::mat4 model_matrix;
@@ -22,13 +67,23 @@ struct plane_push_constant {
 	alignas(16) glm::mat4 projection_matrix;
 };
 
+// upscale.frag, the scene target to the swapchain image
+struct upscale_push_data {
+	glm::vec2 uv_scale; // the part of the scene target rendered this frame
+	glm::vec2 texel_size; // of the scene target
+	float sharpness;
+};
+
 class device_context {
 public:
-	device_context(const std::vector<vertex>& plane, const std::vector<uint32_t>& plane_indices, const std::vector<blade>& grass)
-		: blades_num_(grass.size())
+	// plane is the terrain, drawn chunk by chunk out of one vertex and one index buffer.
+	// the grass is streamed into a pool of blade_pool_size blades, see tile_streamer.hpp
+	// startup work runs on jobs wherever it does not depend on the previous step
+	device_context(const std::vector<vertex>& plane, const std::vector<uint32_t>& plane_indices, uint32_t blade_pool_size, job_system& jobs)
+		: jobs_(jobs), blades_num_(blade_pool_size)
 	{
 		init_window();
-		init_vulkan(plane, plane_indices, grass);
+		init_vulkan(plane, plane_indices);
 	}
 
 	~device_context() {
@@ -45,63 +100,481 @@ private:
 		glfwInit();
 		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 		window_ = glfwCreateWindow(tools::params::WIDTH, tools::params::HEIGHT, "grass", nullptr, nullptr);
+
+		// the window is only queried on the main thread, the swapchain may be
+		// rebuilt on the render thread. it gets these, see recreate_swapchain
+		int width = 0;
+		int height = 0;
+		glfwGetFramebufferSize(window_, &width, &height);
+		framebuffer_extent_ = vk::Extent2D{ static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+
+		const auto mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+		monitor_refresh_rate_ = mode && mode->refreshRate > 0 ? mode->refreshRate : 60;
+	}
+
+	void init_vulkan(const std::vector<vertex> &plane, const std::vector<uint32_t> &plane_indices) {
+		const auto startup_begin = std::chrono::steady_clock::now();
+
+		// the disk work needs no device, it starts before anything else
+		load_shaders();
+		auto texture_decode = jobs_.submit("decode texture", [this] { timed("decode texture", [this] { decode_texture(); }); });
+
+		timed("instance", [&] {
+			create_instance();
+			create_surface();
+			setup_debug_messenger();
+		});
+
+		timed("device", [&] {
+			pick_pysical_device();
+			create_logical_device();
+			create_timelines();
+			create_pipeline_cache();
+			plan_blade_shards();
+			load_workgroup_sizes();
+		});
+
+		timed("swapchain and render passes", [&] {
+			create_swapchain();
+			create_image_views();
+			create_render_pass();
+			create_card_render_pass();
+			create_upscale_render_pass();
+		});
+
+		timed("descriptor set layouts", [&] {
+			create_plane_descriptor_set_layout();
+			create_compute_descritpor_set_layout();
+			create_upscale_descriptor_set_layout();
+		});
+
+		// every pipeline only needs the layouts and the render passes by now, and
+		// writes members of its own. vkCreate*Pipelines may run concurrently
+		const auto pipeline_task = [this](const char* name, void (device_context::*create)()) {
+			return jobs_.submit(name, [this, name, create] { timed(name, [this, create] { (this->*create)(); }); });
+		};
+
+		auto plane_pipeline = pipeline_task("plane pipeline", &device_context::create_plane_graphics_pipeline);
+		auto grass_pipelines = pipeline_task("grass pipelines", &device_context::create_grass_tessellation_pipeline);
+		auto compute_pipelines = pipeline_task("compute pipelines", &device_context::create_compute_pipeline);
+		auto sort_pipelines = pipeline_task("sort pipelines", &device_context::create_sort_pipelines);
+		auto hiz_pipeline = pipeline_task("hiz pipeline", &device_context::create_hiz_pipeline);
+		auto upscale_pipeline = pipeline_task("upscale pipeline", &device_context::create_upscale_pipeline);
+
+		timed("command pool", [&] { create_command_pool(); });
+
+		// the uploads and layout transitions from here on go into one submission
+		begin_upload_batch();
+
+		timed("depth and framebuffers", [&] {
+			create_depth_resources();
+			create_scene_target();
+			create_framebuffers();
+		});
+
+		jobs_.wait(texture_decode);
+
+		timed("texture", [&] {
+			create_texture_image();
+			create_texture_image_view();
+			create_texture_sampler();
+		});
+
+		timed("card image", [&] { create_card_image(); });
+
+		// drawn with the strip pipeline of the near lod
+		jobs_.wait(grass_pipelines);
+		timed("card bake", [&] { bake_grass_card(); });
+
+		timed("buffers", [&] {
+			create_vertex_buffer(plane);
+			create_index_buffer(plane_indices);
+
+			create_blade_pool_buffer();
+			create_tile_streaming_buffers();
+			create_culled_grass_buffer();
+			create_sorted_grass_buffer();
+			create_depth_buckets_buffer();
+			create_indirect_commands_buffer();
+			create_blade_states_buffer();
+			create_awake_blades_buffer();
+			create_card_buffer();
+
+			create_uniform_buffers();
+
+			create_cull_stats_buffer();
+			create_stats_readback();
+			create_blade_address_table();
+		});
+
+		timed("descriptor sets", [&] {
+			create_descriptor_pool();
+			create_descriptor_sets();
+			create_card_descriptor_set();
+			create_upscale_descriptor_set();
+		});
+
+		jobs_.wait(hiz_pipeline);
+		timed("hiz resources", [&] { create_hiz_resources(); });
+
+		timed("compute descriptor sets", [&] {
+			create_mesh_descriptor_set();
+			create_compute_descriptor_sets();
+			get_compute_queue();
+		});
+
+		timed("frame resources", [&] {
+			create_query_pools();
+			create_command_buffers();
+			create_sync_objects();
+		});
+
+		timed("upload submission", [&] { submit_upload_batch(); });
+
+		jobs_.wait({ plane_pipeline, compute_pipelines, sort_pipelines, upscale_pipeline });
+
+		print_startup_report(std::chrono::steady_clock::now() - startup_begin);
 	}
 
-	void init_vulkan(const std::vector<vertex> &plane, const std::vector<uint32_t> &plane_indices, const std::vector<blade> &grass) {
-		create_instance();
-		create_surface();
-		setup_debug_messenger();
-		pick_pysical_device();
-		create_logical_device();
+	// shaders come from the table compiled into the executable, a .spv file of the same
+	// name in the working directory overrides its entry and is read on a worker.
+	// whoever builds a pipeline waits for its own
+	void load_shaders() {
+		// every entry exists before any task runs, each task only fills its own
+		for (const auto& shader : shader_table())
+			shaders_[shader.file];
+
+		for (auto& [file, shader] : shaders_) {
+			if (!std::filesystem::exists(file)) {
+				shader.code = find_embedded_shader(file);
+				continue;
+			}
+
+			shader.loaded = jobs_.submit("read shader", [&shader, path = file] {
+				shader.override_code = read_spirv(path);
+				shader.code = shader.override_code;
+			});
+		}
+	}
 
-		create_swapchain();
-		create_image_views();
-		create_render_pass();
-		create_plane_descriptor_set_layout();
+	// a shader found nowhere throws here, when it is actually needed, not while loading
+	std::span<const uint32_t> shader_code(const std::string& file) {
+		// a reload builds from the code it read, which goes into shaders_ at a frame boundary
+		if (reload_batch_)
+			if (auto reloaded = reload_code_.find(file); reloaded != reload_code_.end()) return reloaded->second;
 
-		create_plane_graphics_pipeline();
-		create_grass_tessellation_pipeline();
+		auto& shader = shaders_.at(file);
+		if (shader.loaded) jobs_.wait(shader.loaded);
 
-		create_command_pool();
+		if (shader.code.empty()) throw std::runtime_error("shader " + file + " is neither embedded nor in the working directory!");
 
-		create_depth_resources();
-		create_framebuffers();
+		return shader.code;
+	}
+
+	struct shader_pipelines {
+		const char* file;
+		void (device_context::*create)(); // builds every pipeline the shader goes into
+	};
+
+	static std::span<const shader_pipelines> shader_table() {
+		static const shader_pipelines table[] = {
+			{ "plane.vert.spv", &device_context::create_plane_graphics_pipeline },
+			{ "plane.frag.spv", &device_context::create_plane_graphics_pipeline },
+			{ "grass.vert.spv", &device_context::create_grass_tessellation_pipeline },
+			{ "grass.frag.spv", &device_context::create_grass_tessellation_pipeline },
+			{ "grass.tesc.spv", &device_context::create_grass_tessellation_pipeline },
+			{ "grass.tese.spv", &device_context::create_grass_tessellation_pipeline },
+			{ "grass_fp16.tese.spv", &device_context::create_grass_tessellation_pipeline },
+			{ "grass_strip.vert.spv", &device_context::create_grass_tessellation_pipeline },
+			{ "grass_card.vert.spv", &device_context::create_grass_tessellation_pipeline },
+			{ "grass_card.frag.spv", &device_context::create_grass_tessellation_pipeline },
+			{ "grass.task.spv", &device_context::create_grass_tessellation_pipeline },
+			{ "grass.mesh.spv", &device_context::create_grass_tessellation_pipeline },
+			{ "grass.comp.spv", &device_context::create_compute_pipeline },
+			{ "grass_stats.comp.spv", &device_context::create_compute_pipeline },
+			{ "grass_physics.comp.spv", &device_context::create_compute_pipeline },
+			{ "grass_physics_fp16.comp.spv", &device_context::create_compute_pipeline },
+			{ "grass_sort.comp.spv", &device_context::create_sort_pipelines },
+			{ "hiz.comp.spv", &device_context::create_hiz_pipeline },
+			{ "upscale.vert.spv", &device_context::create_upscale_pipeline },
+			{ "upscale.frag.spv", &device_context::create_upscale_pipeline }
+		};
 
-		create_texture_image();
-		create_texture_image_view();
-		create_texture_sampler();
+		return table;
+	}
 
-		create_vertex_buffer(plane);
-		create_index_buffer(plane_indices);
+	struct shader_variant {
+		const char* file;
+		const char* source;
+		const char* define;
+	};
+
+	// compiled from the same GLSL as the shader of the source's name, with define defined
+	static std::span<const shader_variant> shader_variants() {
+		static const shader_variant variants[] = {
+			{ "grass_physics_fp16.comp.spv", "grass_physics.comp", "BLADE_FP16" },
+			{ "grass_fp16.tese.spv", "grass.tese", "BLADE_FP16" },
+			{ "grass_stats.comp.spv", "grass.comp", "CULL_STATS" }
+		};
 
-		create_grass_vertex_buffer(grass);
-		create_culled_grass_buffer(grass);
-		create_indirect_commands_buffer(grass);
+		return variants;
+	}
 
-		create_uniform_buffers();
+	// the variant of a shader with define if it was compiled, the shader itself otherwise
+	std::string shader_variant_of(const std::string& file, std::string_view define) {
+		for (const auto& variant : shader_variants()) {
+			if (variant.source + std::string(".spv") != file || variant.define != define) continue;
 
-		create_descriptor_pool();
-		create_descriptor_sets();
+			if (reload_batch_ && reload_code_.contains(variant.file)) return variant.file;
 
-		create_compute_descritpor_set_layout();
-		create_compute_descriptor_sets();
-		create_compute_pipeline();
-		get_compute_queue();
+			auto& shader = shaders_.at(variant.file);
+			if (shader.loaded) jobs_.wait(shader.loaded);
 
-		create_command_buffers();
+			return shader.code.empty() ? file : variant.file;
+		}
 
-		create_sync_objects();
+		return file;
 	}
-	
+
+	// the fp16 variant where the device does fp16 arithmetic, the fp32 one otherwise
+	std::string blade_shader(const std::string& file) {
+		return blade_fp16_ ? shader_variant_of(file, "BLADE_FP16") : file;
+	}
+
+	// the counting variant of grass.comp where the device has subgroup ballots in compute,
+	// the one without any subgroup operation otherwise
+	std::string cull_shader() {
+		return cull_stats_ ? shader_variant_of("grass.comp.spv", "CULL_STATS") : "grass.comp.spv";
+	}
+
+public:
+	bool fp16_physics() {
+		return blade_shader("grass_physics.comp.spv") != "grass_physics.comp.spv";
+	}
+
+	// the cull pass fills blade_cull_stats, see grass.comp
+	bool cull_stats() {
+		return cull_shader() != "grass.comp.spv";
+	}
+
+	// GRASS_SHADER_RELOAD=1: from now on the loose shaders are watched, see update_shader_reload
+	void watch_shaders() {
+		std::vector<std::string> files;
+
+		for (const auto& shader : shader_table())
+			files.push_back(shader.file);
+
+		shader_watcher_.emplace(std::move(files), std::chrono::milliseconds(tools::params::SHADER_WATCH_INTERVAL_MS));
+	}
+
+	// once a frame, before anything is recorded. swaps in the pipelines of a finished
+	// reload, destroys the ones they replaced once no frame in flight can use them,
+	// and starts a reload on a worker if a shader changed. never waits for the device.
+	// retired swapchains go here as well, see recreate_swapchain
+	void update_shader_reload() {
+		const uint64_t completed = logical_device_.getSemaphoreCounterValue(graphics_timeline_);
+
+		std::erase_if(retired_pipelines_, [this, completed](const retired_pipeline& retired) {
+			if (completed < retired.last_use) return false;
+
+			logical_device_.destroyPipeline(retired.pipeline);
+			return true;
+		});
+
+		std::erase_if(retired_swapchains_, [this, completed](const retired_swapchain& retired) {
+			if (completed < retired.last_use) return false;
+
+			logical_device_.destroySwapchainKHR(retired.swapchain);
+			return true;
+		});
+
+		if (!shader_watcher_) return;
+
+		// the tuning kernels are built from shaders_ on the workers, the reloaded code waits for them
+		if (reload_) {
+			if (!reload_->done() || (tuning_build_ && !tuning_build_->done())) return;
+			finish_reload();
+		}
+
+		auto changes = shader_watcher_->poll();
+		if (changes.binaries.empty() && changes.sources.empty()) return;
+
+		// in the background, or the render thread's waits would run the compiles in a frame
+		reload_ = jobs_.submit_background("reload shaders", [this, changes = std::move(changes)] { reload_shaders(changes); });
+	}
+
+private:
+	// on a worker, while frames are being drawn with the old pipelines
+	void reload_shaders(const shader_watcher::changes& changes) {
+		const auto begin = std::chrono::steady_clock::now();
+
+		// the .spv written here is reported by a later poll and rebuilt then
+		for (const auto& source : changes.sources) {
+			const auto command = std::string(tools::params::SHADER_COMPILER) + " " + source + " -o " + source + ".spv";
+
+			if (std::system(command.c_str()) != 0)
+				std::cerr << "failed to compile " << source << ", is " << tools::params::SHADER_COMPILER << " on the path?" << std::endl;
+
+			for (const auto& variant : shader_variants()) {
+				if (source != variant.source) continue;
+
+				const auto variant_command = std::string(tools::params::SHADER_COMPILER) + " -D" + variant.define + " " + source + " -o " + variant.file;
+
+				if (std::system(variant_command.c_str()) != 0)
+					std::cerr << "failed to compile the " << variant.define << " variant of " << source << std::endl;
+			}
+		}
+
+		std::vector<void (device_context::*)()> rebuilds;
+
+		// shaders_ is left alone, other threads build from it meanwhile, see finish_reload
+		for (const auto& file : changes.binaries) {
+			reload_code_[file] = read_spirv(file);
+
+			for (const auto& entry : shader_table())
+				if (entry.file == file && std::find(rebuilds.begin(), rebuilds.end(), entry.create) == rebuilds.end())
+					rebuilds.push_back(entry.create);
+		}
+
+		// unchanged stages of a rebuilt group come out of the pipeline cache
+		reload_batch_ = &reloaded_pipelines_;
+
+		try {
+			for (auto create : rebuilds)
+				(this->*create)();
+		}
+		catch (...) {
+			reload_batch_ = nullptr;
+			throw;
+		}
+
+		reload_batch_ = nullptr;
+
+		reload_duration_ = std::chrono::steady_clock::now() - begin;
+	}
+
+	void finish_reload() {
+		const auto reload = std::move(reload_);
+
+		try {
+			jobs_.wait(reload);
+		}
+		catch (const std::exception& error) {
+			// whatever was built before the failure never went into use
+			for (const auto& reloaded : reloaded_pipelines_)
+				logical_device_.destroyPipeline(reloaded.pipeline);
+
+			reloaded_pipelines_.clear();
+			reload_code_.clear();
+
+			std::cerr << "shader reload failed, the old pipelines stay: " << error.what() << std::endl;
+			return;
+		}
+
+		// nothing builds from shaders_ right now, see update_shader_reload
+		for (auto& [file, code] : reload_code_) {
+			auto& shader = shaders_.at(file);
+			shader.override_code = std::move(code);
+			shader.code = shader.override_code;
+		}
+
+		reload_code_.clear();
+
+		if (reloaded_pipelines_.empty()) return;
+
+		for (const auto& [slot, pipeline] : reloaded_pipelines_) {
+			retired_pipelines_.push_back({ *slot, graphics_timeline_value_ });
+			*slot = pipeline;
+		}
+
+		std::cout << "reloaded " << reloaded_pipelines_.size() << " pipelines in "
+			<< std::chrono::duration<double, std::milli>(reload_duration_).count() << " ms" << std::endl;
+
+		reloaded_pipelines_.clear();
+	}
+
+	// every pipeline is stored through here. during a reload it is held back instead,
+	// the one in use is only replaced at a frame boundary, see finish_reload
+	void set_pipeline(vk::Pipeline& slot, vk::Pipeline pipeline) {
+		if (reload_batch_) reload_batch_->push_back({ &slot, pipeline });
+		else slot = pipeline;
+	}
+
+	// in memory only, shared by the startup tasks and every reload
+	void create_pipeline_cache() {
+		pipeline_cache_ = logical_device_.createPipelineCache(vk::PipelineCacheCreateInfo{});
+	}
+
+	void decode_texture() {
+		int tex_width;
+		int tex_height;
+		int tex_channels;
+
+		auto pixels = stbi_load(TEXTURE_PATH, &tex_width, &tex_height, &tex_channels, STBI_rgb_alpha);
+
+		if (!pixels) throw std::runtime_error("failed to load texture image!");
+
+		decoded_texture_.width = tex_width;
+		decoded_texture_.height = tex_height;
+		decoded_texture_.pixels.assign(pixels, pixels + static_cast<size_t>(tex_width) * tex_height * 4);
+
+		stbi_image_free(pixels);
+	}
+
+	// runs step on the calling thread and adds it to the startup report
+	template<typename F>
+	void timed(const char* name, F&& step) {
+		const auto begin = std::chrono::steady_clock::now();
+		step();
+		const auto end = std::chrono::steady_clock::now();
+
+		std::lock_guard lock(startup_mutex_);
+		startup_steps_.push_back({ name, job_system::thread_index(), begin, end });
+	}
+
+	void print_startup_report(std::chrono::steady_clock::duration total) const {
+		const auto milliseconds = [](auto duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+
+		auto steps = startup_steps_;
+		std::sort(steps.begin(), steps.end(), [](const auto& a, const auto& b) { return a.begin < b.begin; });
+
+		std::cout << "startup: " << milliseconds(total) << " ms" << std::endl;
+
+		for (const auto& step : steps) {
+			std::cout << "  " << std::left << std::setw(28) << step.name << std::right << std::setw(9) << std::fixed << std::setprecision(2)
+				<< milliseconds(step.end - step.begin) << " ms  thread " << step.thread << std::endl;
+		}
+
+		std::cout.unsetf(std::ios::floatfield);
+	}
+
 	void cleanup() {
 		logical_device_.waitIdle();
 
+		// a reload may still be building, nothing it made is in use
+		if (reload_) {
+			try {
+				jobs_.wait(reload_);
+			}
+			catch (const std::exception&) {}
+
+			for (const auto& reloaded : reloaded_pipelines_)
+				logical_device_.destroyPipeline(reloaded.pipeline);
+		}
+
+		for (const auto& retired : retired_pipelines_)
+			logical_device_.destroyPipeline(retired.pipeline);
+
+		logical_device_.destroyPipelineCache(pipeline_cache_);
+
 		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
 			logical_device_.destroySemaphore(image_available_semaphores[i]);
 			logical_device_.destroySemaphore(render_finished_semaphores[i]);
-			logical_device_.destroyFence(in_flight_fences[i]);
 		}
 
+		logical_device_.destroySemaphore(graphics_timeline_);
+		logical_device_.destroySemaphore(compute_timeline_);
+
 		logical_device_.destroyCommandPool(command_pool);
 
 		cleanup_swapchain();
@@ -126,27 +599,107 @@ private:
 		logical_device_.destroyBuffer(plane_vertex_buffer_);
 		logical_device_.freeMemory(plane_vertex_buffer_memory_);
 
-		logical_device_.destroyBuffer(blades_buffer);
-		logical_device_.freeMemory(blades_buffer_memory);
+		for (uint32_t shard = 0; shard < shard_count_; ++shard) {
+			logical_device_.destroyBuffer(blade_shards_[shard]);
+			logical_device_.freeMemory(blade_shard_memories_[shard]);
+
+			logical_device_.destroyBuffer(state_shards_[shard]);
+			logical_device_.freeMemory(state_shard_memories_[shard]);
+		}
+
+		logical_device_.destroyBuffer(tile_table_buffer_);
+		logical_device_.freeMemory(tile_table_buffer_memory_);
+
+		logical_device_.destroyBuffer(tile_staging_buffer_);
+		logical_device_.unmapMemory(tile_staging_buffer_memory_);
+		logical_device_.freeMemory(tile_staging_buffer_memory_);
 
 		logical_device_.destroyBuffer(culled_blades_buffer);
 		logical_device_.freeMemory(culled_blades_buffer_memory);
 
+		logical_device_.destroyBuffer(sorted_blades_buffer_);
+		logical_device_.freeMemory(sorted_blades_buffer_memory_);
+
+		logical_device_.destroyBuffer(depth_buckets_buffer_);
+		logical_device_.freeMemory(depth_buckets_buffer_memory_);
+
+		if (pipeline_statistics_query_pool_)
+			logical_device_.destroyQueryPool(pipeline_statistics_query_pool_);
+
 		logical_device_.destroyBuffer(indirect_draw_commands_buffer_);
 		logical_device_.freeMemory(indirect_draw_commands_buffer_memory_);
 
+		logical_device_.destroyBuffer(awake_blades_buffer_);
+		logical_device_.freeMemory(awake_blades_buffer_memory_);
+
+		logical_device_.destroyBuffer(cull_stats_buffer_);
+		logical_device_.freeMemory(cull_stats_buffer_memory_);
+
+		logical_device_.destroyBuffer(stats_readback_buffer_);
+		logical_device_.unmapMemory(stats_readback_buffer_memory_);
+		logical_device_.freeMemory(stats_readback_buffer_memory_);
+
+		logical_device_.destroyBuffer(blade_address_table_buffer_);
+		logical_device_.freeMemory(blade_address_table_buffer_memory_);
+
+		logical_device_.destroySampler(hiz_sampler_);
+		logical_device_.destroyDescriptorSetLayout(hiz_set_layout_);
+		logical_device_.destroyPipelineLayout(hiz_pipeline_layout_);
+		logical_device_.destroyPipeline(hiz_pipeline_);
+
 
 		logical_device_.destroyPipelineLayout(plane_pipeline_layout_);
 		logical_device_.destroyPipeline(plane_graphics_pipeline_);
 		logical_device_.destroyRenderPass(render_pass);
 
+		logical_device_.destroySampler(upscale_sampler_);
+		logical_device_.destroyDescriptorSetLayout(upscale_set_layout_);
+		logical_device_.destroyPipelineLayout(upscale_pipeline_layout_);
+		logical_device_.destroyPipeline(upscale_pipeline_);
+		logical_device_.destroyRenderPass(upscale_render_pass_);
+
 		logical_device_.destroyPipelineLayout(grass_pipeline_layout_);
-		logical_device_.destroyPipeline(grass_pipeline_);
+		for (auto& pipeline : grass_tessellation_pipelines_)
+			logical_device_.destroyPipeline(pipeline);
+		for (auto& pipeline : grass_strip_pipelines_)
+			logical_device_.destroyPipeline(pipeline);
+
+		logical_device_.destroyDescriptorSetLayout(card_set_layout_);
+		logical_device_.destroyPipelineLayout(card_pipeline_layout_);
+		logical_device_.destroyPipeline(card_pipeline_);
+
+		logical_device_.destroySampler(card_sampler_);
+		logical_device_.destroyImageView(card_image_view_);
+		logical_device_.destroyImage(card_image_);
+		logical_device_.freeMemory(card_image_memory_);
+
+		logical_device_.destroyBuffer(card_buffer_);
+		logical_device_.freeMemory(card_buffer_memory_);
+
+		if (mesh_shaders_) {
+			logical_device_.destroyDescriptorSetLayout(mesh_set_layout_);
+			logical_device_.destroyPipelineLayout(mesh_pipeline_layout_);
+			logical_device_.destroyPipeline(mesh_pipeline_);
+		}
 
 		logical_device_.destroyDescriptorSetLayout(compute_set_layout_);
 		
 		logical_device_.destroyPipelineLayout(compute_pipeline_layout_);
 		logical_device_.destroyPipeline(compute_pipeline_);
+		logical_device_.destroyPipeline(physics_pipeline_);
+
+		destroy_tuning_pipelines();
+		destroy_fp16_reference();
+
+		if (compute_timestamp_pool_)
+			logical_device_.destroyQueryPool(compute_timestamp_pool_);
+
+		if (scene_timestamp_pool_)
+			logical_device_.destroyQueryPool(scene_timestamp_pool_);
+
+		logical_device_.destroyPipelineLayout(sort_pipeline_layout_);
+		for (auto& pipeline : sort_pipelines_)
+			logical_device_.destroyPipeline(pipeline);
 
 		logical_device_.destroy();
 		instance_.destroySurfaceKHR(surface_);
@@ -162,7 +715,13 @@ private:
 		auto requested_extensions = get_required_extensions();
 		std::vector<const char*> requested_layers = { "VK_LAYER_KHRONOS_validation", "VK_LAYER_LUNARG_monitor" };
 
+		// vkCmdDrawIndirectCount is core since 1.2
+		auto app_info = vk::ApplicationInfo{};
+		app_info.pApplicationName = "grass";
+		app_info.apiVersion = VK_API_VERSION_1_2;
+
 		auto createInfo = vk::InstanceCreateInfo{};
+		createInfo.pApplicationInfo = &app_info;
 		createInfo.ppEnabledExtensionNames = requested_extensions.data();
 		createInfo.enabledExtensionCount = static_cast<uint32_t>(requested_extensions.size());
 		createInfo.enabledLayerCount = static_cast<uint32_t>(requested_layers.size());
@@ -245,25 +804,133 @@ private:
 		device_create_info.pQueueCreateInfos = queue_create_infos.data();
 		device_create_info.queueCreateInfoCount = static_cast<uint32_t>(queue_create_infos.size());
 
-		device_create_info.enabledExtensionCount = static_cast<uint32_t>(tools::requested_extensions.size());
-		device_create_info.ppEnabledExtensionNames = tools::requested_extensions.data();
+		auto extensions = tools::requested_extensions;
+
+		// task and mesh shaders replace the tessellated grass wherever they are available,
+		// display timing tells when frames actually reached the screen
+		bool mesh_shader_extension = false;
+		for (const auto& extension : physical_device_.enumerateDeviceExtensionProperties()) {
+			mesh_shader_extension |= std::string_view(extension.extensionName.data()) == VK_EXT_MESH_SHADER_EXTENSION_NAME;
+			display_timing_ |= std::string_view(extension.extensionName.data()) == VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME;
+		}
+
+		// what the device supports, to pick from
+		vk::StructureChain<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features, vk::PhysicalDeviceMeshShaderFeaturesEXT> supported;
+		if (!mesh_shader_extension) supported.unlink<vk::PhysicalDeviceMeshShaderFeaturesEXT>();
+
+		physical_device_.getFeatures2(&supported.get<vk::PhysicalDeviceFeatures2>());
+
+		const auto& supported_core = supported.get<vk::PhysicalDeviceFeatures2>().features;
+		const auto& supported_vulkan12 = supported.get<vk::PhysicalDeviceVulkan12Features>();
+
+		// tessellated patches, and strip buckets drawn from their first instance on
+		if (!supported_core.tessellationShader || !supported_core.drawIndirectFirstInstance)
+			throw std::runtime_error("the grass needs tessellationShader and drawIndirectFirstInstance!");
+
+		// only what is used gets enabled. robustBufferAccess and the like cost performance
+		// for nothing, and the features the code depends on are listed here
+		vk::StructureChain<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features, vk::PhysicalDeviceMeshShaderFeaturesEXT> features;
+
+		auto& core = features.get<vk::PhysicalDeviceFeatures2>().features;
+		core.samplerAnisotropy = true;
+		core.tessellationShader = true;
+		core.drawIndirectFirstInstance = true;
+		core.pipelineStatisticsQuery = supported_core.pipelineStatisticsQuery; // see create_query_pools
+
+		// the missing required ones are reported by plan_blade_shards
+		auto& vulkan12 = features.get<vk::PhysicalDeviceVulkan12Features>();
+		vulkan12.bufferDeviceAddress = supported_vulkan12.bufferDeviceAddress;
+		vulkan12.timelineSemaphore = supported_vulkan12.timelineSemaphore;
+		vulkan12.drawIndirectCount = supported_vulkan12.drawIndirectCount;
+
+		// blade physics and the tessellated curve in fp16, see grass_physics.comp
+		vulkan12.shaderFloat16 = tools::params::BLADE_FP16 && supported_vulkan12.shaderFloat16;
+		blade_fp16_ = vulkan12.shaderFloat16;
+
+		vulkan12_features_ = vulkan12;
+		vulkan12_features_.pNext = nullptr;
 
-		auto features = physical_device_.getFeatures();
-		features.samplerAnisotropy = true;
+		// the counting variant of the cull pass needs ballots, see cull_shader
+		const auto subgroup = physical_device_.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceSubgroupProperties>().get<vk::PhysicalDeviceSubgroupProperties>();
 
-		device_create_info.pEnabledFeatures = &features;
+		cull_stats_ = tools::params::CULL_STATS
+			&& (subgroup.supportedStages & vk::ShaderStageFlagBits::eCompute)
+			&& (subgroup.supportedOperations & vk::SubgroupFeatureFlagBits::eBallot);
+
+		if (mesh_shader_extension) {
+			const auto& supported_mesh = supported.get<vk::PhysicalDeviceMeshShaderFeaturesEXT>();
+			mesh_shaders_ = supported_mesh.taskShader && supported_mesh.meshShader;
+		}
+
+		if (mesh_shaders_) {
+			auto& mesh_features = features.get<vk::PhysicalDeviceMeshShaderFeaturesEXT>();
+			mesh_features.taskShader = true;
+			mesh_features.meshShader = true;
+		}
+		else features.unlink<vk::PhysicalDeviceMeshShaderFeaturesEXT>();
+
+		if (mesh_shaders_) extensions.push_back(VK_EXT_MESH_SHADER_EXTENSION_NAME);
+		if (display_timing_) extensions.push_back(VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME);
+
+		device_create_info.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+		device_create_info.ppEnabledExtensionNames = extensions.data();
+
+		device_create_info.pEnabledFeatures = nullptr;
+		device_create_info.pNext = &features.get<vk::PhysicalDeviceFeatures2>();
 
 		logical_device_ = physical_device_.createDevice(device_create_info);
 
+		if (mesh_shaders_)
+			cmd_draw_mesh_tasks_ = reinterpret_cast<PFN_vkCmdDrawMeshTasksEXT>(logical_device_.getProcAddr("vkCmdDrawMeshTasksEXT"));
+
+		if (display_timing_) {
+			get_refresh_cycle_duration_ = reinterpret_cast<PFN_vkGetRefreshCycleDurationGOOGLE>(logical_device_.getProcAddr("vkGetRefreshCycleDurationGOOGLE"));
+			get_past_presentation_timing_ = reinterpret_cast<PFN_vkGetPastPresentationTimingGOOGLE>(logical_device_.getProcAddr("vkGetPastPresentationTimingGOOGLE"));
+		}
+
 		graphics_queue_ = logical_device_.getQueue(indices.graphics_family, 0);
 		present_queue_ = logical_device_.getQueue(indices.present_family, 0);
 	}
 
-	void create_swapchain() {
+	// the pool is split into shards of whole tiles that no storage buffer binding can exceed,
+	// and the lod buckets of the culled buffer get what fits into a single binding
+	void plan_blade_shards() {
+		const vk::DeviceSize max_range = physical_device_.getProperties().limits.maxStorageBufferRange;
+
+		uint32_t shard_blades = static_cast<uint32_t>(std::min<vk::DeviceSize>(max_range / sizeof(blade), blades_num_));
+		if (tools::params::BLADE_SHARD_LIMIT > 0) shard_blades = std::min(shard_blades, tools::params::BLADE_SHARD_LIMIT);
+
+		blades_per_shard_ = shard_blades / tools::params::BLADES_PER_TILE * tools::params::BLADES_PER_TILE;
+
+		if (blades_per_shard_ == 0)
+			throw std::runtime_error("a tile of blades does not fit into a storage buffer binding!");
+
+		shard_count_ = (blades_num_ + blades_per_shard_ - 1) / blades_per_shard_;
+
+		if (shard_count_ > MAX_BLADE_SHARDS)
+			throw std::runtime_error("the blade pool needs more than MAX_BLADE_SHARDS shards!");
+
+		// the grass shaders reach every blade buffer through blade_buffer_addresses
+		if (!vulkan12_features_.bufferDeviceAddress)
+			throw std::runtime_error("the grass passes need bufferDeviceAddress!");
+
+		// every submission is waited for through one, see create_timelines
+		if (!vulkan12_features_.timelineSemaphore)
+			throw std::runtime_error("the frame loop needs timelineSemaphore!");
+
+		bucket_capacity_ = static_cast<uint32_t>(std::min<vk::DeviceSize>(max_range / (sizeof(blade) * lod_count), blades_num_));
+	}
+
+	uint32_t shard_size(uint32_t shard) const {
+		return std::min(blades_per_shard_, blades_num_ - shard * blades_per_shard_);
+	}
+
+	// old_swapchain is retired by the new one, see recreate_swapchain
+	void create_swapchain(vk::SwapchainKHR old_swapchain = nullptr) {
 		auto swapchain_properties = vk_tools::query_swapchain_support_details(physical_device_, surface_);
 		auto surface_format = vk_tools::choose_surface_format(swapchain_properties.formats);
-		auto present_mode = vk_tools::choose_present_mode(swapchain_properties.present_modes);
-		auto extent = vk_tools::choose_swap_extent(swapchain_properties.capabilities, window_);
+		auto present_mode = vk_tools::choose_present_mode(swapchain_properties.present_modes, present_policy_);
+		auto extent = vk_tools::choose_swap_extent(swapchain_properties.capabilities, framebuffer_extent_);
 
 		auto image_count = ++swapchain_properties.capabilities.minImageCount;
 
@@ -303,12 +970,14 @@ private:
 		create_info.compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque;
 		create_info.presentMode = present_mode; //speaks for itself
 		create_info.clipped = true;
+		create_info.oldSwapchain = old_swapchain;
 
 		swapchain_ = logical_device_.createSwapchainKHR(create_info);
 
 		swapchain_images = logical_device_.getSwapchainImagesKHR(swapchain_);
 		swapchain_image_format_ = surface_format.format;
 		swapchain_extent = extent;
+		present_mode_ = present_mode;
 	}
 
 	void create_image_views() {
@@ -328,7 +997,7 @@ private:
 		color_attachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
 		
 		color_attachment.initialLayout = vk::ImageLayout::eUndefined;
-		color_attachment.finalLayout = vk::ImageLayout::ePresentSrcKHR;
+		color_attachment.finalLayout = vk::ImageLayout::eShaderReadOnlyOptimal; // the scene target, upscaled to the swapchain
 
 		vk::AttachmentReference color_attachment_ref{};
 		color_attachment_ref.attachment = 0;
@@ -339,12 +1008,12 @@ private:
 		depth_attachment.format = find_depth_format();
 		depth_attachment.samples = vk::SampleCountFlagBits::e1;
 		depth_attachment.initialLayout = vk::ImageLayout::eUndefined;
-		depth_attachment.finalLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal;
+		depth_attachment.finalLayout = vk::ImageLayout::eShaderReadOnlyOptimal; // the Hi-Z pyramid is built from it
 
 		
 		depth_attachment.loadOp = vk::AttachmentLoadOp::eClear;
 
-		depth_attachment.storeOp = vk::AttachmentStoreOp::eDontCare;
+		depth_attachment.storeOp = vk::AttachmentStoreOp::eStore;
 		depth_attachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
 		depth_attachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
 
@@ -362,8 +1031,11 @@ private:
 		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
 		dependency.dstSubpass = 0;
 
+		// the previous Hi-Z build must be done reading depth, and the previous upscale
+		// reading color, before they are cleared
 		dependency.srcStageMask =
-			vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests;
+			vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eEarlyFragmentTests |
+			vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eFragmentShader;
 		dependency.srcAccessMask = vk::AccessFlagBits::eNone;
 
 		dependency.dstStageMask =
@@ -371,19 +1043,68 @@ private:
 		dependency.dstAccessMask =
 			vk::AccessFlagBits::eColorAttachmentWrite | vk::AccessFlagBits::eDepthStencilAttachmentWrite;
 
+		// the Hi-Z build reads the depth, the upscale the color
+		vk::SubpassDependency depth_read_dependency{};
+		depth_read_dependency.srcSubpass = 0;
+		depth_read_dependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+		depth_read_dependency.srcStageMask = vk::PipelineStageFlagBits::eLateFragmentTests | vk::PipelineStageFlagBits::eColorAttachmentOutput;
+		depth_read_dependency.srcAccessMask = vk::AccessFlagBits::eDepthStencilAttachmentWrite | vk::AccessFlagBits::eColorAttachmentWrite;
+		depth_read_dependency.dstStageMask = vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eFragmentShader;
+		depth_read_dependency.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+
 		std::array<vk::AttachmentDescription, 2> attachments = { color_attachment, depth_attachment };
+		std::array<vk::SubpassDependency, 2> dependencies = { dependency, depth_read_dependency };
 
 		vk::RenderPassCreateInfo render_pass_create_info{};
 		render_pass_create_info.attachmentCount = attachments.size();
 		render_pass_create_info.pAttachments = attachments.data();
 		render_pass_create_info.pSubpasses = &subpass;
 		render_pass_create_info.subpassCount = 1;
-		render_pass_create_info.dependencyCount = 1;
-		render_pass_create_info.pDependencies = &dependency;
+		render_pass_create_info.dependencyCount = dependencies.size();
+		render_pass_create_info.pDependencies = dependencies.data();
 
 		render_pass = logical_device_.createRenderPass(render_pass_create_info);
 	}
 
+	// the upscale of the scene target, it covers every pixel of the swapchain image
+	void create_upscale_render_pass() {
+		vk::AttachmentDescription color_attachment{};
+		color_attachment.format = swapchain_image_format_;
+		color_attachment.samples = vk::SampleCountFlagBits::e1;
+		color_attachment.loadOp = vk::AttachmentLoadOp::eDontCare;
+		color_attachment.storeOp = vk::AttachmentStoreOp::eStore;
+		color_attachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+		color_attachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+		color_attachment.initialLayout = vk::ImageLayout::eUndefined;
+		color_attachment.finalLayout = vk::ImageLayout::ePresentSrcKHR;
+
+		vk::AttachmentReference color_attachment_ref{ 0, vk::ImageLayout::eColorAttachmentOptimal };
+
+		vk::SubpassDescription subpass{};
+		subpass.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
+		subpass.colorAttachmentCount = 1;
+		subpass.pColorAttachments = &color_attachment_ref;
+
+		// the swapchain image is written once the acquire semaphore is waited on
+		vk::SubpassDependency dependency{};
+		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependency.dstSubpass = 0;
+		dependency.srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+		dependency.srcAccessMask = vk::AccessFlagBits::eNone;
+		dependency.dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+		dependency.dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite;
+
+		vk::RenderPassCreateInfo render_pass_info{};
+		render_pass_info.attachmentCount = 1;
+		render_pass_info.pAttachments = &color_attachment;
+		render_pass_info.subpassCount = 1;
+		render_pass_info.pSubpasses = &subpass;
+		render_pass_info.dependencyCount = 1;
+		render_pass_info.pDependencies = &dependency;
+
+		upscale_render_pass_ = logical_device_.createRenderPass(render_pass_info);
+	}
+
 	void create_plane_descriptor_set_layout() {
 		vk::DescriptorSetLayoutBinding ubo_layout_binding{};
 		ubo_layout_binding.binding = 0;
@@ -406,8 +1127,8 @@ private:
 	}
 
 	void create_plane_graphics_pipeline() {
-		auto vert_shader_code = read_file("plane.vert.spv");
-		auto frag_shader_code = read_file("plane.frag.spv");
+		const auto vert_shader_code = shader_code("plane.vert.spv");
+		const auto frag_shader_code = shader_code("plane.frag.spv");
 		
 		auto vert_shader_module = create_shader_module(vert_shader_code);
 		auto frag_shader_module = create_shader_module(frag_shader_code);
@@ -551,7 +1272,9 @@ private:
 		pipeline_layout_create_info.pushConstantRangeCount = 1;
 		pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
 
-		plane_pipeline_layout_ = logical_device_.createPipelineLayout(pipeline_layout_create_info);
+		// kept across shader reloads, only the pipelines are rebuilt
+		if (!plane_pipeline_layout_)
+			plane_pipeline_layout_ = logical_device_.createPipelineLayout(pipeline_layout_create_info);
 
 		vk::GraphicsPipelineCreateInfo pipeline_info{};
 		pipeline_info.stageCount = 2;
@@ -569,49 +1292,48 @@ private:
 		pipeline_info.renderPass = render_pass;
 		pipeline_info.subpass = 0;
 
-		plane_graphics_pipeline_ = logical_device_.createGraphicsPipeline(nullptr, pipeline_info).value;
+		set_pipeline(plane_graphics_pipeline_, logical_device_.createGraphicsPipeline(pipeline_cache_, pipeline_info).value);
 
 		logical_device_.destroyShaderModule(vert_shader_module);
 		logical_device_.destroyShaderModule(frag_shader_module);
 	}
 
-	void create_grass_tessellation_pipeline() {
-
-		auto vert_shader_code = read_file("grass.vert.spv");
-		auto frag_shader_code = read_file("grass.frag.spv");
+	// the scene target, sampled bilinearly. clamped, the upscale keeps to the rendered part itself
+	void create_upscale_descriptor_set_layout() {
+		vk::DescriptorSetLayoutBinding scene_binding{};
+		scene_binding.binding = 0;
+		scene_binding.descriptorCount = 1;
+		scene_binding.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+		scene_binding.stageFlags = vk::ShaderStageFlagBits::eFragment;
 
-		auto TCS_shader_code = read_file("grass.tesc.spv");
-		auto TES_shader_code = read_file("grass.tese.spv");
-
-		auto vert_shader_module = create_shader_module(vert_shader_code);
-		auto frag_shader_module = create_shader_module(frag_shader_code);
-		auto TCS_shader_module = create_shader_module(TCS_shader_code);
-		auto TES_shader_module = create_shader_module(TES_shader_code);
+		vk::DescriptorSetLayoutCreateInfo layout_info{};
+		layout_info.bindingCount = 1;
+		layout_info.pBindings = &scene_binding;
 
-		vk::PipelineShaderStageCreateInfo vert_shader_stage_create_info{};
-		vert_shader_stage_create_info.module = vert_shader_module;
-		vert_shader_stage_create_info.stage = vk::ShaderStageFlagBits::eVertex;
-		vert_shader_stage_create_info.pName = "main";
+		upscale_set_layout_ = logical_device_.createDescriptorSetLayout(layout_info);
 
-		vk::PipelineShaderStageCreateInfo frag_shader_stage_create_info{};
-		frag_shader_stage_create_info.module = frag_shader_module;
-		frag_shader_stage_create_info.stage = vk::ShaderStageFlagBits::eFragment;
-		frag_shader_stage_create_info.pName = "main";
+		vk::SamplerCreateInfo sampler_info{};
+		sampler_info.magFilter = vk::Filter::eLinear;
+		sampler_info.minFilter = vk::Filter::eLinear;
+		sampler_info.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+		sampler_info.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+		sampler_info.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+		sampler_info.mipmapMode = vk::SamplerMipmapMode::eNearest;
 
-		vk::PipelineShaderStageCreateInfo TCS_shader_stage_create_info{};
-		TCS_shader_stage_create_info.module = TCS_shader_module;
-		TCS_shader_stage_create_info.stage = vk::ShaderStageFlagBits::eTessellationControl;
-		TCS_shader_stage_create_info.pName = "main";
+		upscale_sampler_ = logical_device_.createSampler(sampler_info);
+	}
 
-		vk::PipelineShaderStageCreateInfo TES_shader_stage_create_info{};
-		TES_shader_stage_create_info.module = TES_shader_module;
-		TES_shader_stage_create_info.stage = vk::ShaderStageFlagBits::eTessellationEvaluation;
-		TES_shader_stage_create_info.pName = "main";
+	// a single triangle over the whole swapchain image, no vertex input, no depth
+	void create_upscale_pipeline() {
+		const auto vert_shader_code = shader_code("upscale.vert.spv");
+		const auto frag_shader_code = shader_code("upscale.frag.spv");
 
+		auto vert_shader_module = create_shader_module(vert_shader_code);
+		auto frag_shader_module = create_shader_module(frag_shader_code);
 
 		vk::PipelineShaderStageCreateInfo shader_stages[] = {
-			vert_shader_stage_create_info, frag_shader_stage_create_info,
-			TCS_shader_stage_create_info, TES_shader_stage_create_info
+			{ {}, vk::ShaderStageFlagBits::eVertex, vert_shader_module, "main" },
+			{ {}, vk::ShaderStageFlagBits::eFragment, frag_shader_module, "main" }
 		};
 
 		std::vector<vk::DynamicState> dynamic_states = {
@@ -625,57 +1347,169 @@ private:
 
 		vk::PipelineVertexInputStateCreateInfo vertex_input_create_info{};
 
-		auto binding_description = blade::binding_description();
-		auto attribute_descriptions = blade::attribute_descriptions();
-
-		vertex_input_create_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribute_descriptions.size());
-		vertex_input_create_info.pVertexAttributeDescriptions = attribute_descriptions.data();
-		vertex_input_create_info.vertexBindingDescriptionCount = 1;
-		vertex_input_create_info.pVertexBindingDescriptions = &binding_description;
-
 		vk::PipelineInputAssemblyStateCreateInfo input_assembly_create_info{};
-		input_assembly_create_info.topology = vk::PrimitiveTopology::ePatchList;
-
-		vk::Viewport viewport{};
-		viewport.height = static_cast<float>(swapchain_extent.height);
-		viewport.width = static_cast<float>(swapchain_extent.width);
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-
-		vk::Rect2D scissor{};
-		scissor.offset = vk::Offset2D{ 0, 0 };
-		scissor.extent = swapchain_extent;
+		input_assembly_create_info.topology = vk::PrimitiveTopology::eTriangleList;
 
 		vk::PipelineViewportStateCreateInfo viewport_state_create_info{};
-		viewport_state_create_info.scissorCount = 1;
 		viewport_state_create_info.viewportCount = 1;
-		viewport_state_create_info.pViewports = &viewport;
-		viewport_state_create_info.pScissors = &scissor;
+		viewport_state_create_info.scissorCount = 1;
 
 		vk::PipelineRasterizationStateCreateInfo rasterization_state_create_info{};
-		rasterization_state_create_info.depthClampEnable = false;
-		rasterization_state_create_info.rasterizerDiscardEnable = false; 
 		rasterization_state_create_info.polygonMode = vk::PolygonMode::eFill;
 		rasterization_state_create_info.lineWidth = 1.0f;
-		rasterization_state_create_info.cullMode = vk::CullModeFlagBits::eBack;
-		rasterization_state_create_info.frontFace = vk::FrontFace::eCounterClockwise;
-		rasterization_state_create_info.depthBiasEnable = false; 
+		rasterization_state_create_info.cullMode = vk::CullModeFlagBits::eNone;
 
 		vk::PipelineMultisampleStateCreateInfo multisample_state_create_info{};
-		multisample_state_create_info.minSampleShading = 1;
-		multisample_state_create_info.sampleShadingEnable = false;
 		multisample_state_create_info.rasterizationSamples = vk::SampleCountFlagBits::e1;
 
 		vk::PipelineColorBlendAttachmentState color_blend_attachment{};
 		color_blend_attachment.blendEnable = false;
-		color_blend_attachment.colorWriteMask = /*RGBA*/
+		color_blend_attachment.colorWriteMask =
 			vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
 
-		color_blend_attachment.alphaBlendOp = vk::BlendOp::eAdd;
-		color_blend_attachment.srcAlphaBlendFactor = vk::BlendFactor::eOne;
-		color_blend_attachment.dstAlphaBlendFactor = vk::BlendFactor::eZero;
+		vk::PipelineColorBlendStateCreateInfo color_blending{};
+		color_blending.attachmentCount = 1;
+		color_blending.pAttachments = &color_blend_attachment;
+
+		vk::PushConstantRange push_constant_range{};
+		push_constant_range.size = sizeof(upscale_push_data);
+		push_constant_range.offset = 0;
+		push_constant_range.stageFlags = vk::ShaderStageFlagBits::eFragment;
+
+		vk::PipelineLayoutCreateInfo pipeline_layout_create_info{};
+		pipeline_layout_create_info.setLayoutCount = 1;
+		pipeline_layout_create_info.pSetLayouts = &upscale_set_layout_;
+		pipeline_layout_create_info.pushConstantRangeCount = 1;
+		pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+		// kept across shader reloads, only the pipeline is rebuilt
+		if (!upscale_pipeline_layout_)
+			upscale_pipeline_layout_ = logical_device_.createPipelineLayout(pipeline_layout_create_info);
+
+		vk::GraphicsPipelineCreateInfo pipeline_info{};
+		pipeline_info.stageCount = 2;
+		pipeline_info.pStages = shader_stages;
+		pipeline_info.pVertexInputState = &vertex_input_create_info;
+		pipeline_info.pInputAssemblyState = &input_assembly_create_info;
+		pipeline_info.pViewportState = &viewport_state_create_info;
+		pipeline_info.pRasterizationState = &rasterization_state_create_info;
+		pipeline_info.pMultisampleState = &multisample_state_create_info;
+		pipeline_info.pDynamicState = &dynamic_state_create_info;
+		pipeline_info.pColorBlendState = &color_blending;
+		pipeline_info.layout = upscale_pipeline_layout_;
+		pipeline_info.renderPass = upscale_render_pass_;
+		pipeline_info.subpass = 0;
+
+		set_pipeline(upscale_pipeline_, logical_device_.createGraphicsPipeline(pipeline_cache_, pipeline_info).value);
+
+		logical_device_.destroyShaderModule(vert_shader_module);
+		logical_device_.destroyShaderModule(frag_shader_module);
+	}
+
+	void create_grass_tessellation_pipeline() {
+
+		const auto vert_shader_code = shader_code("grass.vert.spv");
+		const auto frag_shader_code = shader_code("grass.frag.spv");
+
+		const auto TCS_shader_code = shader_code("grass.tesc.spv");
+		const auto TES_shader_code = shader_code(blade_shader("grass.tese.spv"));
+
+		const auto strip_shader_code = shader_code("grass_strip.vert.spv");
+
+		auto vert_shader_module = create_shader_module(vert_shader_code);
+		auto frag_shader_module = create_shader_module(frag_shader_code);
+		auto TCS_shader_module = create_shader_module(TCS_shader_code);
+		auto TES_shader_module = create_shader_module(TES_shader_code);
+		auto strip_shader_module = create_shader_module(strip_shader_code);
+
+		vk::PipelineShaderStageCreateInfo vert_shader_stage_create_info{};
+		vert_shader_stage_create_info.module = vert_shader_module;
+		vert_shader_stage_create_info.stage = vk::ShaderStageFlagBits::eVertex;
+		vert_shader_stage_create_info.pName = "main";
+
+		vk::PipelineShaderStageCreateInfo frag_shader_stage_create_info{};
+		frag_shader_stage_create_info.module = frag_shader_module;
+		frag_shader_stage_create_info.stage = vk::ShaderStageFlagBits::eFragment;
+		frag_shader_stage_create_info.pName = "main";
+
+		vk::PipelineShaderStageCreateInfo TCS_shader_stage_create_info{};
+		TCS_shader_stage_create_info.module = TCS_shader_module;
+		TCS_shader_stage_create_info.stage = vk::ShaderStageFlagBits::eTessellationControl;
+		TCS_shader_stage_create_info.pName = "main";
+
+		vk::PipelineShaderStageCreateInfo TES_shader_stage_create_info{};
+		TES_shader_stage_create_info.module = TES_shader_module;
+		TES_shader_stage_create_info.stage = vk::ShaderStageFlagBits::eTessellationEvaluation;
+		TES_shader_stage_create_info.pName = "main";
+
+
+		vk::PipelineShaderStageCreateInfo shader_stages[] = {
+			vert_shader_stage_create_info, frag_shader_stage_create_info,
+			TCS_shader_stage_create_info, TES_shader_stage_create_info
+		};
+
+		std::vector<vk::DynamicState> dynamic_states = {
+			vk::DynamicState::eViewport,
+			vk::DynamicState::eScissor
+		};
+
+		vk::PipelineDynamicStateCreateInfo dynamic_state_create_info{};
+		dynamic_state_create_info.pDynamicStates = dynamic_states.data();
+		dynamic_state_create_info.dynamicStateCount = static_cast<uint32_t>(dynamic_states.size());
+
+		vk::PipelineVertexInputStateCreateInfo vertex_input_create_info{};
+
+		auto binding_description = blade::binding_description();
+		auto attribute_descriptions = blade::attribute_descriptions();
+
+		vertex_input_create_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribute_descriptions.size());
+		vertex_input_create_info.pVertexAttributeDescriptions = attribute_descriptions.data();
+		vertex_input_create_info.vertexBindingDescriptionCount = 1;
+		vertex_input_create_info.pVertexBindingDescriptions = &binding_description;
+
+		vk::PipelineInputAssemblyStateCreateInfo input_assembly_create_info{};
+		input_assembly_create_info.topology = vk::PrimitiveTopology::ePatchList;
+
+		vk::Viewport viewport{};
+		viewport.height = static_cast<float>(swapchain_extent.height);
+		viewport.width = static_cast<float>(swapchain_extent.width);
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+
+		vk::Rect2D scissor{};
+		scissor.offset = vk::Offset2D{ 0, 0 };
+		scissor.extent = swapchain_extent;
+
+		vk::PipelineViewportStateCreateInfo viewport_state_create_info{};
+		viewport_state_create_info.scissorCount = 1;
+		viewport_state_create_info.viewportCount = 1;
+		viewport_state_create_info.pViewports = &viewport;
+		viewport_state_create_info.pScissors = &scissor;
+
+		vk::PipelineRasterizationStateCreateInfo rasterization_state_create_info{};
+		rasterization_state_create_info.depthClampEnable = false;
+		rasterization_state_create_info.rasterizerDiscardEnable = false; 
+		rasterization_state_create_info.polygonMode = vk::PolygonMode::eFill;
+		rasterization_state_create_info.lineWidth = 1.0f;
+		rasterization_state_create_info.cullMode = vk::CullModeFlagBits::eBack;
+		rasterization_state_create_info.frontFace = vk::FrontFace::eCounterClockwise;
+		rasterization_state_create_info.depthBiasEnable = false; 
+
+		vk::PipelineMultisampleStateCreateInfo multisample_state_create_info{};
+		multisample_state_create_info.minSampleShading = 1;
+		multisample_state_create_info.sampleShadingEnable = false;
+		multisample_state_create_info.rasterizationSamples = vk::SampleCountFlagBits::e1;
+
+		vk::PipelineColorBlendAttachmentState color_blend_attachment{};
+		color_blend_attachment.blendEnable = false;
+		color_blend_attachment.colorWriteMask = /*RGBA*/
+			vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+
+		color_blend_attachment.alphaBlendOp = vk::BlendOp::eAdd;
+		color_blend_attachment.srcAlphaBlendFactor = vk::BlendFactor::eOne;
+		color_blend_attachment.dstAlphaBlendFactor = vk::BlendFactor::eZero;
 
 		color_blend_attachment.colorBlendOp = vk::BlendOp::eAdd;
 		color_blend_attachment.srcColorBlendFactor = vk::BlendFactor::eOne;
@@ -706,9 +1540,10 @@ private:
 		vk::PipelineTessellationStateCreateInfo tessellation_state_info{};
 		tessellation_state_info.patchControlPoints = 1;
 
+		// the strip vertex shader of the far lod reads the matrices too
 		vk::PushConstantRange vertex_range{};
 		vertex_range.offset = 0;
-		vertex_range.size = sizeof(glm::mat4);
+		vertex_range.size = sizeof(blade_push_constant_data);
 		vertex_range.stageFlags = vk::ShaderStageFlagBits::eVertex;
 
 		vk::PushConstantRange TES_range{};
@@ -724,7 +1559,8 @@ private:
 		pipeline_layout_create_info.setLayoutCount = 0;
 		pipeline_layout_create_info.pSetLayouts = nullptr;
 
-		grass_pipeline_layout_ = logical_device_.createPipelineLayout(pipeline_layout_create_info);
+		if (!grass_pipeline_layout_)
+			grass_pipeline_layout_ = logical_device_.createPipelineLayout(pipeline_layout_create_info);
 
 		vk::GraphicsPipelineCreateInfo pipeline_info{};
 		pipeline_info.stageCount = sizeof(shader_stages) / sizeof(shader_stages[0]);
@@ -743,15 +1579,300 @@ private:
 		pipeline_info.renderPass = render_pass;
 		pipeline_info.subpass = 0;
 
-		grass_pipeline_ = logical_device_.createGraphicsPipeline(nullptr, pipeline_info).value;
+		// near and mid lods only differ in the tessellation level
+		vk::SpecializationMapEntry tess_level_entry{ 0, 0, sizeof(float) };
+
+		const float tess_levels[] = { tools::params::NEAR_TESSELLATION_LEVEL, tools::params::MID_TESSELLATION_LEVEL };
+
+		for (uint32_t lod : { near_lod, mid_lod }) {
+			vk::SpecializationInfo tess_specialization_info{};
+			tess_specialization_info.mapEntryCount = 1;
+			tess_specialization_info.pMapEntries = &tess_level_entry;
+			tess_specialization_info.dataSize = sizeof(float);
+			tess_specialization_info.pData = &tess_levels[lod];
+
+			shader_stages[2].pSpecializationInfo = &tess_specialization_info;
+
+			set_pipeline(grass_tessellation_pipelines_[lod], logical_device_.createGraphicsPipeline(pipeline_cache_, pipeline_info).value);
+		}
+
+		// a triangle strip per blade instance, no tessellation stages. the far lod
+		// always draws these, near and mid ones only on grass_path::strips
+		vk::SpecializationMapEntry segments_entry{ 0, 0, sizeof(uint32_t) };
+
+		const uint32_t strip_segments[] = {
+			tools::params::NEAR_STRIP_SEGMENTS, tools::params::MID_STRIP_SEGMENTS, tools::params::FAR_STRIP_SEGMENTS
+		};
+
+		vk::PipelineShaderStageCreateInfo strip_shader_stage_create_info{};
+		strip_shader_stage_create_info.module = strip_shader_module;
+		strip_shader_stage_create_info.stage = vk::ShaderStageFlagBits::eVertex;
+		strip_shader_stage_create_info.pName = "main";
+
+		vk::PipelineShaderStageCreateInfo strip_shader_stages[] = {
+			strip_shader_stage_create_info, frag_shader_stage_create_info
+		};
+
+		auto instance_binding_description = blade::binding_description(vk::VertexInputRate::eInstance);
+		vertex_input_create_info.pVertexBindingDescriptions = &instance_binding_description;
+
+		input_assembly_create_info.topology = vk::PrimitiveTopology::eTriangleStrip;
+
+		pipeline_info.stageCount = sizeof(strip_shader_stages) / sizeof(strip_shader_stages[0]);
+		pipeline_info.pStages = strip_shader_stages;
+		pipeline_info.pTessellationState = nullptr;
+
+		for (uint32_t lod = 0; lod < lod_count; ++lod) {
+			vk::SpecializationInfo strip_specialization_info{};
+			strip_specialization_info.mapEntryCount = 1;
+			strip_specialization_info.pMapEntries = &segments_entry;
+			strip_specialization_info.dataSize = sizeof(uint32_t);
+			strip_specialization_info.pData = &strip_segments[lod];
+
+			strip_shader_stages[0].pSpecializationInfo = &strip_specialization_info;
+
+			set_pipeline(grass_strip_pipelines_[lod], logical_device_.createGraphicsPipeline(pipeline_cache_, pipeline_info).value);
+		}
+
+		create_card_pipelines(pipeline_info, strip_shader_stage_create_info, frag_shader_stage_create_info);
+
+		if (mesh_shaders_) create_grass_mesh_pipeline(pipeline_info, frag_shader_stage_create_info);
 
 		logical_device_.destroyShaderModule(vert_shader_module);
 		logical_device_.destroyShaderModule(frag_shader_module);
 		logical_device_.destroyShaderModule(TCS_shader_module);
 		logical_device_.destroyShaderModule(TES_shader_module);
+		logical_device_.destroyShaderModule(strip_shader_module);
+	}
+
+	// the far field cards, and the strips that render blades into their texture,
+	// with the fixed-function state of the other grass pipelines
+	void create_card_pipelines(vk::GraphicsPipelineCreateInfo pipeline_info, vk::PipelineShaderStageCreateInfo strip_shader_stage_create_info,
+		const vk::PipelineShaderStageCreateInfo& frag_shader_stage_create_info) {
+
+		vk::SpecializationMapEntry segments_entry{ 0, 0, sizeof(uint32_t) };
+		const uint32_t segments = tools::params::NEAR_STRIP_SEGMENTS;
+
+		vk::SpecializationInfo strip_specialization_info{};
+		strip_specialization_info.mapEntryCount = 1;
+		strip_specialization_info.pMapEntries = &segments_entry;
+		strip_specialization_info.dataSize = sizeof(segments);
+		strip_specialization_info.pData = &segments;
+
+		strip_shader_stage_create_info.pSpecializationInfo = &strip_specialization_info;
+
+		vk::PipelineShaderStageCreateInfo bake_shader_stages[] = {
+			strip_shader_stage_create_info, frag_shader_stage_create_info
+		};
+
+		// still the instanced strip vertex input here
+		auto bake_info = pipeline_info;
+		bake_info.stageCount = sizeof(bake_shader_stages) / sizeof(bake_shader_stages[0]);
+		bake_info.pStages = bake_shader_stages;
+		bake_info.renderPass = card_render_pass_;
+
+		// the card is baked once at startup, its render pass is gone by the time of a reload
+		if (!reload_batch_)
+			card_bake_pipeline_ = logical_device_.createGraphicsPipeline(pipeline_cache_, bake_info).value;
+
+		const auto card_vert_shader_code = shader_code("grass_card.vert.spv");
+		const auto card_frag_shader_code = shader_code("grass_card.frag.spv");
+
+		auto card_vert_shader_module = create_shader_module(card_vert_shader_code);
+		auto card_frag_shader_module = create_shader_module(card_frag_shader_code);
+
+		const float card_fade[] = { tools::params::CARD_FADE_START, tools::params::CARD_FADE_END };
+
+		vk::SpecializationMapEntry fade_entries[] = {
+			{ 0, 0, sizeof(float) },
+			{ 1, sizeof(float), sizeof(float) }
+		};
+
+		vk::SpecializationInfo card_specialization_info{};
+		card_specialization_info.mapEntryCount = sizeof(fade_entries) / sizeof(fade_entries[0]);
+		card_specialization_info.pMapEntries = fade_entries;
+		card_specialization_info.dataSize = sizeof(card_fade);
+		card_specialization_info.pData = card_fade;
+
+		vk::PipelineShaderStageCreateInfo card_vert_shader_stage_create_info{};
+		card_vert_shader_stage_create_info.module = card_vert_shader_module;
+		card_vert_shader_stage_create_info.stage = vk::ShaderStageFlagBits::eVertex;
+		card_vert_shader_stage_create_info.pName = "main";
+		card_vert_shader_stage_create_info.pSpecializationInfo = &card_specialization_info;
+
+		vk::PipelineShaderStageCreateInfo card_frag_shader_stage_create_info{};
+		card_frag_shader_stage_create_info.module = card_frag_shader_module;
+		card_frag_shader_stage_create_info.stage = vk::ShaderStageFlagBits::eFragment;
+		card_frag_shader_stage_create_info.pName = "main";
+
+		vk::PipelineShaderStageCreateInfo card_shader_stages[] = {
+			card_vert_shader_stage_create_info, card_frag_shader_stage_create_info
+		};
+
+		vk::DescriptorSetLayoutBinding card_binding{};
+		card_binding.binding = 0;
+		card_binding.descriptorCount = 1;
+		card_binding.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+		card_binding.stageFlags = vk::ShaderStageFlagBits::eFragment;
+
+		vk::DescriptorSetLayoutCreateInfo set_layout_info{};
+		set_layout_info.bindingCount = 1;
+		set_layout_info.pBindings = &card_binding;
+
+		if (!card_set_layout_)
+			card_set_layout_ = logical_device_.createDescriptorSetLayout(set_layout_info);
+
+		vk::PushConstantRange range{};
+		range.offset = 0;
+		range.size = sizeof(blade_card_push_data);
+		range.stageFlags = vk::ShaderStageFlagBits::eVertex;
+
+		vk::PipelineLayoutCreateInfo layout_info{};
+		layout_info.pushConstantRangeCount = 1;
+		layout_info.pPushConstantRanges = &range;
+		layout_info.setLayoutCount = 1;
+		layout_info.pSetLayouts = &card_set_layout_;
+
+		if (!card_pipeline_layout_)
+			card_pipeline_layout_ = logical_device_.createPipelineLayout(layout_info);
+
+		auto binding_description = grass_card::binding_description();
+		auto attribute_descriptions = grass_card::attribute_descriptions();
+
+		vk::PipelineVertexInputStateCreateInfo vertex_input_create_info{};
+		vertex_input_create_info.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribute_descriptions.size());
+		vertex_input_create_info.pVertexAttributeDescriptions = attribute_descriptions.data();
+		vertex_input_create_info.vertexBindingDescriptionCount = 1;
+		vertex_input_create_info.pVertexBindingDescriptions = &binding_description;
+
+		// the cards face every way, both sides have to show
+		auto rasterization_state_create_info = *pipeline_info.pRasterizationState;
+		rasterization_state_create_info.cullMode = vk::CullModeFlagBits::eNone;
+
+		pipeline_info.stageCount = sizeof(card_shader_stages) / sizeof(card_shader_stages[0]);
+		pipeline_info.pStages = card_shader_stages;
+		pipeline_info.pVertexInputState = &vertex_input_create_info;
+		pipeline_info.pRasterizationState = &rasterization_state_create_info;
+		pipeline_info.layout = card_pipeline_layout_;
+
+		set_pipeline(card_pipeline_, logical_device_.createGraphicsPipeline(pipeline_cache_, pipeline_info).value);
+
+		logical_device_.destroyShaderModule(card_vert_shader_module);
+		logical_device_.destroyShaderModule(card_frag_shader_module);
+	}
+
+	// same fixed-function state as the other grass pipelines, no vertex input at all
+	void create_grass_mesh_pipeline(vk::GraphicsPipelineCreateInfo pipeline_info, const vk::PipelineShaderStageCreateInfo& frag_shader_stage_create_info) {
+		const auto task_shader_code = shader_code("grass.task.spv");
+		const auto mesh_shader_code = shader_code("grass.mesh.spv");
+
+		auto task_shader_module = create_shader_module(task_shader_code);
+		auto mesh_shader_module = create_shader_module(mesh_shader_code);
+
+		// the blades and the tile table come with the push constants
+		vk::DescriptorSetLayoutBinding hiz_binding{};
+		hiz_binding.binding = 0;
+		hiz_binding.descriptorCount = 1;
+		hiz_binding.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+		hiz_binding.stageFlags = vk::ShaderStageFlagBits::eTaskEXT;
+
+		vk::DescriptorSetLayoutCreateInfo set_layout_info{};
+		set_layout_info.bindingCount = 1;
+		set_layout_info.pBindings = &hiz_binding;
+
+		if (!mesh_set_layout_)
+			mesh_set_layout_ = logical_device_.createDescriptorSetLayout(set_layout_info);
+
+		vk::PushConstantRange range{};
+		range.offset = 0;
+		range.size = sizeof(blade_mesh_push_data);
+		range.stageFlags = vk::ShaderStageFlagBits::eTaskEXT | vk::ShaderStageFlagBits::eMeshEXT;
+
+		vk::PipelineLayoutCreateInfo layout_info{};
+		layout_info.pushConstantRangeCount = 1;
+		layout_info.pPushConstantRanges = &range;
+		layout_info.setLayoutCount = 1;
+		layout_info.pSetLayouts = &mesh_set_layout_;
+
+		if (!mesh_pipeline_layout_)
+			mesh_pipeline_layout_ = logical_device_.createPipelineLayout(layout_info);
+
+		struct {
+			float lod_mid_distance = tools::params::LOD_MID_DISTANCE;
+			float lod_far_distance = tools::params::LOD_FAR_DISTANCE;
+			float card_fade_start = tools::params::CARD_FADE_START;
+			float card_fade_end = tools::params::CARD_FADE_END;
+			uint32_t blades_per_tile = tools::params::BLADES_PER_TILE;
+			uint32_t blades_per_shard;
+			uint32_t tile_slots = tools::params::STREAM_POOL_SLOTS;
+		} task_constants;
+
+		task_constants.blades_per_shard = blades_per_shard_;
+
+		vk::SpecializationMapEntry task_entries[] = {
+			{ 0, offsetof(decltype(task_constants), lod_mid_distance), sizeof(float) },
+			{ 1, offsetof(decltype(task_constants), lod_far_distance), sizeof(float) },
+			{ 2, offsetof(decltype(task_constants), card_fade_start), sizeof(float) },
+			{ 3, offsetof(decltype(task_constants), card_fade_end), sizeof(float) },
+			{ 4, offsetof(decltype(task_constants), blades_per_tile), sizeof(uint32_t) },
+			{ 5, offsetof(decltype(task_constants), blades_per_shard), sizeof(uint32_t) },
+			{ 6, offsetof(decltype(task_constants), tile_slots), sizeof(uint32_t) }
+		};
+
+		vk::SpecializationInfo task_specialization_info{};
+		task_specialization_info.mapEntryCount = sizeof(task_entries) / sizeof(task_entries[0]);
+		task_specialization_info.pMapEntries = task_entries;
+		task_specialization_info.dataSize = sizeof(task_constants);
+		task_specialization_info.pData = &task_constants;
+
+		// strip segments of every lod, then the shard size
+		const uint32_t mesh_constants[] = {
+			tools::params::NEAR_STRIP_SEGMENTS, tools::params::MID_STRIP_SEGMENTS, tools::params::FAR_STRIP_SEGMENTS, blades_per_shard_
+		};
+
+		vk::SpecializationMapEntry mesh_entries[] = {
+			{ 0, 0, sizeof(uint32_t) },
+			{ 1, sizeof(uint32_t), sizeof(uint32_t) },
+			{ 2, 2 * sizeof(uint32_t), sizeof(uint32_t) },
+			{ 3, 3 * sizeof(uint32_t), sizeof(uint32_t) }
+		};
+
+		vk::SpecializationInfo mesh_specialization_info{};
+		mesh_specialization_info.mapEntryCount = sizeof(mesh_entries) / sizeof(mesh_entries[0]);
+		mesh_specialization_info.pMapEntries = mesh_entries;
+		mesh_specialization_info.dataSize = sizeof(mesh_constants);
+		mesh_specialization_info.pData = mesh_constants;
+
+		vk::PipelineShaderStageCreateInfo task_shader_stage_create_info{};
+		task_shader_stage_create_info.module = task_shader_module;
+		task_shader_stage_create_info.stage = vk::ShaderStageFlagBits::eTaskEXT;
+		task_shader_stage_create_info.pName = "main";
+		task_shader_stage_create_info.pSpecializationInfo = &task_specialization_info;
+
+		vk::PipelineShaderStageCreateInfo mesh_shader_stage_create_info{};
+		mesh_shader_stage_create_info.module = mesh_shader_module;
+		mesh_shader_stage_create_info.stage = vk::ShaderStageFlagBits::eMeshEXT;
+		mesh_shader_stage_create_info.pName = "main";
+		mesh_shader_stage_create_info.pSpecializationInfo = &mesh_specialization_info;
+
+		vk::PipelineShaderStageCreateInfo mesh_shader_stages[] = {
+			task_shader_stage_create_info, mesh_shader_stage_create_info, frag_shader_stage_create_info
+		};
+
+		pipeline_info.stageCount = sizeof(mesh_shader_stages) / sizeof(mesh_shader_stages[0]);
+		pipeline_info.pStages = mesh_shader_stages;
+		pipeline_info.pVertexInputState = nullptr;
+		pipeline_info.pInputAssemblyState = nullptr;
+		pipeline_info.pTessellationState = nullptr;
+		pipeline_info.layout = mesh_pipeline_layout_;
+
+		set_pipeline(mesh_pipeline_, logical_device_.createGraphicsPipeline(pipeline_cache_, pipeline_info).value);
+
+		logical_device_.destroyShaderModule(task_shader_module);
+		logical_device_.destroyShaderModule(mesh_shader_module);
 	}
 
-	static std::vector<char> read_file(const std::string& path) {
+	static std::vector<uint32_t> read_spirv(const std::string& path) {
 		//ate: start reading at the end of file so we could use the	
 		//read position to determine the size of the file
 
@@ -761,38 +1882,51 @@ private:
 		if (!file.is_open()) throw std::runtime_error("failed to open file!");
 
 		const auto file_size = static_cast<size_t>(file.tellg());
-		std::vector<char> buffer(file_size);
+		if (file_size % sizeof(uint32_t) != 0) throw std::runtime_error(path + " is not SPIR-V!");
+
+		// read straight into words, the code has to be 4 byte aligned anyway
+		std::vector<uint32_t> buffer(file_size / sizeof(uint32_t));
 
 		file.seekg(0);
-		file.read(buffer.data(), file_size);
+		file.read(reinterpret_cast<char*>(buffer.data()), file_size);
 
 		file.close();
 
 		return buffer;
 	}
 
-	vk::ShaderModule create_shader_module(std::vector<char>& shader_code) {
+	vk::ShaderModule create_shader_module(std::span<const uint32_t> shader_code) {
 		vk::ShaderModuleCreateInfo create_info{};
-		create_info.pCode = reinterpret_cast<uint32_t*>(shader_code.data());
-		create_info.codeSize = shader_code.size();
+		create_info.pCode = shader_code.data();
+		create_info.codeSize = shader_code.size_bytes();
 
 		return logical_device_.createShaderModule(create_info);
 	}
 
 	void create_framebuffers() {
+		// the scene is rendered into the scene target at whatever resolution,
+		// so there is a single framebuffer for it, sized for the whole swapchain
+		vk::ImageView scene_attachments[] = { scene_image_view_, depth_image_view };
+
+		vk::FramebufferCreateInfo scene_framebuffer_info{};
+		scene_framebuffer_info.renderPass = render_pass;
+		scene_framebuffer_info.attachmentCount = sizeof(scene_attachments) / sizeof(vk::ImageView);
+		scene_framebuffer_info.pAttachments = scene_attachments;
+		scene_framebuffer_info.layers = 1;
+		scene_framebuffer_info.width = swapchain_extent.width;
+		scene_framebuffer_info.height = swapchain_extent.height;
+
+		scene_framebuffer_ = logical_device_.createFramebuffer(scene_framebuffer_info);
 
 		for (const auto& image_view : swapchain_image_views) {
-			// the color attachment differs for each swap chain frame,
-			// but the same depth image can be used by all of them 
-			// beacuse only a single subpass is running at the same 
-			// time due to our semaphores.
+			// the swapchain images only take the upscale
 
-			vk::ImageView attachments[] = { image_view, depth_image_view };
+			vk::ImageView attachments[] = { image_view };
 
 			vk::FramebufferCreateInfo frame_buffer_info{};
 
 			//only render passes that use the same number and type of attachments
-			frame_buffer_info.renderPass = render_pass;
+			frame_buffer_info.renderPass = upscale_render_pass_;
 
 			frame_buffer_info.attachmentCount = sizeof(attachments) / sizeof(vk::ImageView);
 			frame_buffer_info.pAttachments = attachments;
@@ -819,10 +1953,20 @@ private:
 
 	void create_depth_resources() {
 		auto depth_format = find_depth_format();
-		create_image(swapchain_extent.width, swapchain_extent.height, depth_format, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment, vk::MemoryPropertyFlagBits::eDeviceLocal, depth_image, depth_image_memory);
+		create_image(swapchain_extent.width, swapchain_extent.height, depth_format, vk::ImageTiling::eOptimal, vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal, depth_image, depth_image_memory);
 		depth_image_view = create_image_view(depth_image, depth_format, vk::ImageAspectFlagBits::eDepth);
 	}
 
+	// the scene is rendered here at the dynamic resolution, into its top left corner,
+	// and the upscale samples it. as large as the swapchain, so that scaling is free
+	void create_scene_target() {
+		create_image(swapchain_extent.width, swapchain_extent.height, swapchain_image_format_, vk::ImageTiling::eOptimal,
+			vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled, vk::MemoryPropertyFlagBits::eDeviceLocal,
+			scene_image_, scene_image_memory_);
+
+		scene_image_view_ = create_image_view(scene_image_, swapchain_image_format_, vk::ImageAspectFlagBits::eColor);
+	}
+
 	bool has_stencil_component(const vk::Format& format) {
 		return format == vk::Format::eD24UnormS8Uint || format == vk::Format::eD32SfloatS8Uint;
 	}
@@ -848,11 +1992,11 @@ private:
 	}
 
 	void create_image(uint32_t width, uint32_t height, vk::Format format, vk::ImageTiling tiling, vk::ImageUsageFlags usage,
-		vk::MemoryPropertyFlags properties, vk::Image& image, vk::DeviceMemory& image_memory) {
+		vk::MemoryPropertyFlags properties, vk::Image& image, vk::DeviceMemory& image_memory, uint32_t mip_levels = 1) {
 
 		vk::ImageCreateInfo image_info{};
 		image_info.arrayLayers = 1;
-		image_info.mipLevels = 1;
+		image_info.mipLevels = mip_levels;
 		image_info.sharingMode = vk::SharingMode::eExclusive;
 		image_info.extent.depth = 1;
 		image_info.extent.width = width;
@@ -877,14 +2021,10 @@ private:
 		logical_device_.bindImageMemory(image, image_memory, 0);
 	}
 
+	// from the pixels decode_texture left
 	void create_texture_image() {
-		int tex_width;
-		int tex_height;
-		int tex_channels; 
-
-		auto pixels = stbi_load(TEXTURE_PATH, &tex_width, &tex_height, &tex_channels, STBI_rgb_alpha);
-
-		if (!pixels) throw std::runtime_error("failed to load texture image!");
+		const uint32_t tex_width = decoded_texture_.width;
+		const uint32_t tex_height = decoded_texture_.height;
 
 		vk::DeviceSize image_size = tex_width * tex_height * 4;
 
@@ -900,10 +2040,10 @@ private:
 		);
 
 		auto pdata = logical_device_.mapMemory(staging_buffer_memory, 0, image_size);
-		std::memcpy(pdata, pixels, image_size);
+		std::memcpy(pdata, decoded_texture_.pixels.data(), image_size);
 		logical_device_.unmapMemory(staging_buffer_memory);
 
-		stbi_image_free(pixels);
+		decoded_texture_.pixels = {};
 
 		create_image(
 			tex_width,
@@ -942,8 +2082,10 @@ private:
 			vk::AccessFlagBits::eShaderRead
 		);
 
-		logical_device_.destroyBuffer(staging_buffer);
-		logical_device_.freeMemory(staging_buffer_memory);
+		after_upload([=, this] {
+			logical_device_.destroyBuffer(staging_buffer);
+			logical_device_.freeMemory(staging_buffer_memory);
+		});
 	}
 
 	void transition_image_layout(vk::Image& image, vk::Format format, vk::ImageLayout old_layout, vk::ImageLayout new_layout, vk::ImageAspectFlags image_aspect,
@@ -986,7 +2128,7 @@ private:
 	}
 
 	[[ nodiscard ]]
-	vk::ImageView create_image_view(vk::Image& image, vk::Format format, vk::ImageAspectFlags aspect_flags) {
+	vk::ImageView create_image_view(vk::Image& image, vk::Format format, vk::ImageAspectFlags aspect_flags, uint32_t base_mip_level = 0, uint32_t level_count = 1) {
 
 		vk::ImageViewCreateInfo view_info{};
 		view_info.viewType = vk::ImageViewType::e2D;
@@ -994,25 +2136,216 @@ private:
 		view_info.format = format;
 		view_info.subresourceRange.aspectMask = aspect_flags;
 		view_info.subresourceRange.layerCount = 1;
-		view_info.subresourceRange.levelCount = 1;
+		view_info.subresourceRange.baseMipLevel = base_mip_level;
+		view_info.subresourceRange.levelCount = level_count;
 		view_info.components = vk::ComponentSwizzle::eIdentity;
 
 		return logical_device_.createImageView(view_info);
 	}
 
-	void create_texture_image_view() {
-		texture_image_view = create_image_view(texture_image, vk::Format::eR8G8B8A8Srgb, vk::ImageAspectFlagBits::eColor);
+	// the card texture is rendered into once, then only sampled
+	void create_card_render_pass() {
+		vk::AttachmentDescription color_attachment{};
+		color_attachment.format = vk::Format::eR8G8B8A8Srgb;
+		color_attachment.samples = vk::SampleCountFlagBits::e1;
+		color_attachment.loadOp = vk::AttachmentLoadOp::eClear;
+		color_attachment.storeOp = vk::AttachmentStoreOp::eStore;
+		color_attachment.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
+		color_attachment.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
+		color_attachment.initialLayout = vk::ImageLayout::eUndefined;
+		color_attachment.finalLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+
+		vk::AttachmentReference color_attachment_ref{ 0, vk::ImageLayout::eColorAttachmentOptimal };
+
+		vk::SubpassDescription subpass{};
+		subpass.pipelineBindPoint = vk::PipelineBindPoint::eGraphics;
+		subpass.colorAttachmentCount = 1;
+		subpass.pColorAttachments = &color_attachment_ref;
+
+		vk::SubpassDependency dependency{};
+		dependency.srcSubpass = 0;
+		dependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+		dependency.srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+		dependency.srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite;
+		dependency.dstStageMask = vk::PipelineStageFlagBits::eFragmentShader;
+		dependency.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+
+		vk::RenderPassCreateInfo render_pass_info{};
+		render_pass_info.attachmentCount = 1;
+		render_pass_info.pAttachments = &color_attachment;
+		render_pass_info.subpassCount = 1;
+		render_pass_info.pSubpasses = &subpass;
+		render_pass_info.dependencyCount = 1;
+		render_pass_info.pDependencies = &dependency;
+
+		card_render_pass_ = logical_device_.createRenderPass(render_pass_info);
 	}
 
-	void create_texture_sampler() {
-		vk::SamplerCreateInfo sampler_info{};
+	void create_card_image() {
+		const uint32_t size = tools::params::CARD_TEXTURE_SIZE;
 
-		sampler_info.magFilter = vk::Filter::eNearest;
+		create_image(
+			size,
+			size,
+			vk::Format::eR8G8B8A8Srgb,
+			vk::ImageTiling::eOptimal,
+			vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled,
+			vk::MemoryPropertyFlagBits::eDeviceLocal,
+			card_image_,
+			card_image_memory_
+		);
+
+		card_image_view_ = create_image_view(card_image_, vk::Format::eR8G8B8A8Srgb, vk::ImageAspectFlagBits::eColor);
+
+		vk::SamplerCreateInfo sampler_info{};
+		sampler_info.magFilter = vk::Filter::eLinear;
 		sampler_info.minFilter = vk::Filter::eLinear;
+		sampler_info.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+		sampler_info.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+		sampler_info.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+		sampler_info.mipmapMode = vk::SamplerMipmapMode::eNearest;
 
-		sampler_info.addressModeU = vk::SamplerAddressMode::eRepeat;
-		sampler_info.addressModeV = vk::SamplerAddressMode::eRepeat;
-		sampler_info.addressModeW = vk::SamplerAddressMode::eRepeat;
+		card_sampler_ = logical_device_.createSampler(sampler_info);
+	}
+
+	// renders a patch of the actual blades from the side into the card texture
+	void bake_grass_card() {
+		const uint32_t size = tools::params::CARD_TEXTURE_SIZE;
+		const float width = tools::params::CARD_WIDTH;
+		const float height = tools::params::CARD_HEIGHT;
+
+		auto blades = grass::generate_terrain(tools::params::CARD_BLADES, width);
+		const vk::DeviceSize buffer_size = sizeof(blades[0]) * blades.size();
+
+		vk::Buffer patch_buffer;
+		vk::DeviceMemory patch_buffer_memory;
+
+		create_buffer(
+			buffer_size,
+			vk::BufferUsageFlagBits::eVertexBuffer,
+			vk::MemoryPropertyFlagBits::eHostCoherent | vk::MemoryPropertyFlagBits::eHostVisible,
+			patch_buffer,
+			patch_buffer_memory
+		);
+
+		auto pdata = logical_device_.mapMemory(patch_buffer_memory, 0, buffer_size);
+		std::memcpy(pdata, blades.data(), buffer_size);
+		logical_device_.unmapMemory(patch_buffer_memory);
+
+		vk::FramebufferCreateInfo framebuffer_info{};
+		framebuffer_info.renderPass = card_render_pass_;
+		framebuffer_info.attachmentCount = 1;
+		framebuffer_info.pAttachments = &card_image_view_;
+		framebuffer_info.width = size;
+		framebuffer_info.height = size;
+		framebuffer_info.layers = 1;
+
+		auto framebuffer = logical_device_.createFramebuffer(framebuffer_info);
+
+		auto command_buffer = begin_single_time_commands();
+
+		vk::ClearValue clear_value{};
+		clear_value.color = vk::ClearColorValue{ 0.0f, 0.0f, 0.0f, 0.0f }; // alpha is the coverage
+
+		vk::RenderPassBeginInfo render_pass_info{};
+		render_pass_info.renderPass = card_render_pass_;
+		render_pass_info.framebuffer = framebuffer;
+		render_pass_info.renderArea.extent = vk::Extent2D{ size, size };
+		render_pass_info.clearValueCount = 1;
+		render_pass_info.pClearValues = &clear_value;
+
+		command_buffer.beginRenderPass(render_pass_info, vk::SubpassContents::eInline);
+		command_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, card_bake_pipeline_);
+
+		command_buffer.setViewport(0, vk::Viewport{ 0.0f, 0.0f, static_cast<float>(size), static_cast<float>(size), 0.0f, 1.0f });
+		command_buffer.setScissor(0, vk::Rect2D{ { 0, 0 }, { size, size } });
+
+		// looking down -z at the patch, the card spans it from the ground up
+		blade_push_constant_data push{
+			glm::mat4(1.0f),
+			glm::mat4(1.0f),
+			glm::ortho(-0.5f * width, 0.5f * width, 0.0f, height, -width, width)
+		};
+		push.projection_matrix[1][1] *= -1;
+
+		command_buffer.pushConstants(grass_pipeline_layout_, vk::ShaderStageFlagBits::eVertex, 0, sizeof(glm::mat4), &push);
+		command_buffer.pushConstants(grass_pipeline_layout_, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eTessellationEvaluation,
+			sizeof(glm::mat4), 2 * sizeof(glm::mat4), &push.view_matrix);
+
+		command_buffer.bindVertexBuffers(0, patch_buffer, { 0 });
+		command_buffer.draw(STRIP_VERTICES[near_lod], static_cast<uint32_t>(blades.size()), 0, 0);
+
+		command_buffer.endRenderPass();
+
+		end_single_time_commads(command_buffer);
+
+		// nothing else renders into the card
+		after_upload([=, this] {
+			logical_device_.destroyFramebuffer(framebuffer);
+			logical_device_.destroyBuffer(patch_buffer);
+			logical_device_.freeMemory(patch_buffer_memory);
+
+			logical_device_.destroyPipeline(card_bake_pipeline_);
+			logical_device_.destroyRenderPass(card_render_pass_);
+		});
+	}
+
+	void create_card_descriptor_set() {
+		vk::DescriptorSetAllocateInfo alloc_info{ descriptor_pool, 1, &card_set_layout_ };
+		card_descriptor_set_ = logical_device_.allocateDescriptorSets(alloc_info).front();
+
+		vk::DescriptorImageInfo card_info{};
+		card_info.sampler = card_sampler_;
+		card_info.imageView = card_image_view_;
+		card_info.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+
+		vk::WriteDescriptorSet card_write{};
+		card_write.descriptorCount = 1;
+		card_write.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+		card_write.dstBinding = 0;
+		card_write.dstSet = card_descriptor_set_;
+		card_write.pImageInfo = &card_info;
+
+		logical_device_.updateDescriptorSets(card_write, {});
+	}
+
+	// the scene target is recreated with the swapchain, so is this binding
+	void create_upscale_descriptor_set() {
+		vk::DescriptorSetAllocateInfo alloc_info{ descriptor_pool, 1, &upscale_set_layout_ };
+		upscale_descriptor_set_ = logical_device_.allocateDescriptorSets(alloc_info).front();
+
+		write_upscale_descriptor();
+	}
+
+	void write_upscale_descriptor() {
+		vk::DescriptorImageInfo scene_info{};
+		scene_info.sampler = upscale_sampler_;
+		scene_info.imageView = scene_image_view_;
+		scene_info.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+
+		vk::WriteDescriptorSet scene_write{};
+		scene_write.descriptorCount = 1;
+		scene_write.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+		scene_write.dstBinding = 0;
+		scene_write.dstSet = upscale_descriptor_set_;
+		scene_write.pImageInfo = &scene_info;
+
+		logical_device_.updateDescriptorSets(scene_write, {});
+	}
+
+	void create_texture_image_view() {
+		texture_image_view = create_image_view(texture_image, vk::Format::eR8G8B8A8Srgb, vk::ImageAspectFlagBits::eColor);
+	}
+
+	void create_texture_sampler() {
+		vk::SamplerCreateInfo sampler_info{};
+
+		sampler_info.magFilter = vk::Filter::eNearest;
+		sampler_info.minFilter = vk::Filter::eLinear;
+
+		sampler_info.addressModeU = vk::SamplerAddressMode::eRepeat;
+		sampler_info.addressModeV = vk::SamplerAddressMode::eRepeat;
+		sampler_info.addressModeW = vk::SamplerAddressMode::eRepeat;
 
 		// there is no reason not to use this unless performance is a concern
 		sampler_info.anisotropyEnable = true;
@@ -1031,7 +2364,10 @@ private:
 		texture_sampler = logical_device_.createSampler(sampler_info);
 	}
 
+	// while an upload batch is open these all record into it
 	vk::CommandBuffer begin_single_time_commands() {
+		if (upload_batch_) return upload_batch_;
+
 		vk::CommandBufferAllocateInfo alloc_info{};
 		alloc_info.commandBufferCount = 1;
 		alloc_info.level = vk::CommandBufferLevel::ePrimary;
@@ -1048,18 +2384,54 @@ private:
 	}
 
 	void end_single_time_commads(vk::CommandBuffer& command_buffer) {
+		if (command_buffer == upload_batch_) return;
+
 		command_buffer.end();
 
+		// waits for this submission only, not for the frames in flight on the same queue
+		const uint64_t value = ++graphics_timeline_value_;
+
+		vk::TimelineSemaphoreSubmitInfo timeline_info{};
+		timeline_info.signalSemaphoreValueCount = 1;
+		timeline_info.pSignalSemaphoreValues = &value;
+
 		vk::SubmitInfo submit_info{};
+		submit_info.pNext = &timeline_info;
 		submit_info.commandBufferCount = 1;
 		submit_info.pCommandBuffers = &command_buffer;
+		submit_info.signalSemaphoreCount = 1;
+		submit_info.pSignalSemaphores = &graphics_timeline_;
 
 		graphics_queue_.submit(submit_info);
-		graphics_queue_.waitIdle(); // PROFILING!!
+		wait_timeline(graphics_timeline_, value);
 
 		logical_device_.freeCommandBuffers(command_pool, command_buffer);
 	}
 
+	// one submission and one wait for all the single time commands until submit_upload_batch.
+	// each command still gets its own barriers, they only no longer wait on the queue
+	void begin_upload_batch() {
+		upload_batch_ = begin_single_time_commands();
+	}
+
+	void submit_upload_batch() {
+		auto command_buffer = upload_batch_;
+		upload_batch_ = nullptr;
+
+		end_single_time_commads(command_buffer);
+
+		for (auto& release : after_upload_)
+			release();
+
+		after_upload_.clear();
+	}
+
+	// staging buffers and the like, released once the commands using them have run
+	void after_upload(std::function<void()> release) {
+		if (upload_batch_) after_upload_.push_back(std::move(release));
+		else release();
+	}
+
 	uint32_t find_memory_type(uint32_t supported_types_mask, vk::MemoryPropertyFlags properties) {
 		auto supported_properties = physical_device_.getMemoryProperties();
 		for (uint32_t i = 0; i < supported_properties.memoryTypeCount; ++i)
@@ -1071,6 +2443,7 @@ private:
 		throw std::runtime_error("failed to find suitable memory type!");
 	}
 
+	// buffers with eShaderDeviceAddress usage get memory their address can be taken of
 	void create_buffer(vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, vk::Buffer& buffer, vk::DeviceMemory& buffer_memory) {
 		vk::BufferCreateInfo buffer_info{};
 		buffer_info.size = size;
@@ -1085,6 +2458,9 @@ private:
 		alloc_info.allocationSize = memory_requirements.size;
 		alloc_info.memoryTypeIndex = find_memory_type(memory_requirements.memoryTypeBits, properties);
 
+		vk::MemoryAllocateFlagsInfo flags_info{ vk::MemoryAllocateFlagBits::eDeviceAddress };
+		if (usage & vk::BufferUsageFlagBits::eShaderDeviceAddress) alloc_info.pNext = &flags_info;
+
 		buffer_memory = logical_device_.allocateMemory(alloc_info);
 		logical_device_.bindBufferMemory(buffer, buffer_memory, 0);
 	}
@@ -1123,8 +2499,10 @@ private:
 
 		copy_buffer(plane_vertex_buffer_, staging_buffer, buffer_size);
 
-		logical_device_.destroyBuffer(staging_buffer);
-		logical_device_.freeMemory(staging_buffer_memory);
+		after_upload([=, this] {
+			logical_device_.destroyBuffer(staging_buffer);
+			logical_device_.freeMemory(staging_buffer_memory);
+		});
 	}
 
 	void create_index_buffer(const std::vector<uint32_t> &indices) {
@@ -1155,12 +2533,71 @@ private:
 
 		copy_buffer(plane_index_buffer_, staging_buffer, buffer_size);
 
-		logical_device_.destroyBuffer(staging_buffer);
-		logical_device_.freeMemory(staging_buffer_memory);
+		after_upload([=, this] {
+			logical_device_.destroyBuffer(staging_buffer);
+			logical_device_.freeMemory(staging_buffer_memory);
+		});
 	}
 
-	void create_grass_vertex_buffer(const std::vector<blade> &blades) {
-		const vk::DeviceSize buffer_size = sizeof(blades[0]) * blades.size();
+	// slots of BLADES_PER_TILE blades, filled by the tile uploads of the compute command buffer
+	void create_blade_pool_buffer() {
+		blade_shards_.resize(shard_count_);
+		blade_shard_memories_.resize(shard_count_);
+
+		for (uint32_t shard = 0; shard < shard_count_; ++shard) {
+			create_buffer(
+				sizeof(blade) * shard_size(shard),
+				vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress,
+				vk::MemoryPropertyFlagBits::eDeviceLocal,
+				blade_shards_[shard],
+				blade_shard_memories_[shard]
+			);
+		}
+	}
+
+	void create_tile_streaming_buffers() {
+		// rewritten every frame, visibility included
+		create_buffer(
+			sizeof(grass_tile_slot) * tools::params::STREAM_POOL_SLOTS,
+			vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress,
+			vk::MemoryPropertyFlagBits::eDeviceLocal,
+			tile_table_buffer_,
+			tile_table_buffer_memory_
+		);
+
+		// room for the uploads of each frame in flight, mapped for good. a frame slot's
+		// part is free again once the slot's previous frame is done, see tile_staging_offset
+		const vk::DeviceSize staging_size = tile_staging_offset(MAX_FRAMES_IN_FLIGHT);
+
+		create_buffer(
+			staging_size,
+			vk::BufferUsageFlagBits::eTransferSrc,
+			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+			tile_staging_buffer_,
+			tile_staging_buffer_memory_
+		);
+
+		tile_staging_mapped_ = logical_device_.mapMemory(tile_staging_buffer_memory_, 0, staging_size);
+	}
+
+public:
+	vk::DeviceSize tile_staging_offset(uint32_t frame) const {
+		return sizeof(blade) * tools::params::BLADES_PER_TILE * tools::params::STREAM_UPLOADS_PER_FRAME * frame;
+	}
+
+private:
+	void create_card_buffer() {
+		auto cards = grass::generate_cards(
+			tools::params::CARD_FIELD_DIM, tools::params::CARD_TILE_DIM, tools::params::CARDS_PER_TILE,
+			tools::params::CARD_WIDTH, tools::params::CARD_HEIGHT
+		);
+
+		for (auto& card : cards)
+			card.position.y = terrain::height(card.position.x, card.position.z);
+
+		cards_num_ = static_cast<uint32_t>(cards.size());
+
+		const vk::DeviceSize buffer_size = sizeof(cards[0]) * cards.size();
 
 		vk::Buffer staging_buffer;
 		vk::DeviceMemory staging_buffer_memory;
@@ -1175,42 +2612,64 @@ private:
 
 		create_buffer(
 			buffer_size,
-			vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eVertexBuffer,
+			vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eVertexBuffer,
 			vk::MemoryPropertyFlagBits::eDeviceLocal,
-			blades_buffer,
-			blades_buffer_memory
+			card_buffer_,
+			card_buffer_memory_
 		);
 
 		auto pstaging_data = logical_device_.mapMemory(staging_buffer_memory, 0, buffer_size);
-		std::memcpy(pstaging_data, blades.data(), buffer_size);
+		std::memcpy(pstaging_data, cards.data(), buffer_size);
 		logical_device_.unmapMemory(staging_buffer_memory);
 
-		copy_buffer(blades_buffer, staging_buffer, buffer_size);
+		copy_buffer(card_buffer_, staging_buffer, buffer_size);
 
-		logical_device_.destroyBuffer(staging_buffer);
-		logical_device_.freeMemory(staging_buffer_memory);
+		after_upload([=, this] {
+			logical_device_.destroyBuffer(staging_buffer);
+			logical_device_.freeMemory(staging_buffer_memory);
+		});
 	}
 
-	void create_culled_grass_buffer(const std::vector<blade>& blades) {
-		const vk::DeviceSize buffer_size = sizeof(blades[0]) * blades.size();
+	void create_culled_grass_buffer() {
+		// one range of bucket_capacity_ blades per lod bucket
+		const vk::DeviceSize buffer_size = sizeof(blade) * bucket_capacity_ * lod_count;
 
 		create_buffer(
 			buffer_size,
-			vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eVertexBuffer,
+			vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress,
 			vk::MemoryPropertyFlagBits::eHostVisible,
 			culled_blades_buffer,
 			culled_blades_buffer_memory
 		);
 	}
 
-	void create_indirect_commands_buffer(const std::vector<blade>& blades) {
-		const vk::DeviceSize buffer_size = sizeof(blade_draw_indirect);
+	void create_sorted_grass_buffer() {
+		const vk::DeviceSize buffer_size = sizeof(blade) * bucket_capacity_ * lod_count;
+
+		create_buffer(
+			buffer_size,
+			vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress,
+			vk::MemoryPropertyFlagBits::eDeviceLocal,
+			sorted_blades_buffer_,
+			sorted_blades_buffer_memory_
+		);
+	}
+
+	void create_depth_buckets_buffer() {
+		// counts followed by offsets, the counts are reset every frame
+		create_buffer(
+			2 * sizeof(uint32_t) * DEPTH_BUCKET_COUNT * lod_count,
+			vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eShaderDeviceAddress,
+			vk::MemoryPropertyFlagBits::eDeviceLocal,
+			depth_buckets_buffer_,
+			depth_buckets_buffer_memory_
+		);
+	}
+
+	void create_indirect_commands_buffer() {
+		const vk::DeviceSize buffer_size = sizeof(blade_draw_commands);
 
-		blade_draw_indirect indirect_data;
-		indirect_data.first_instance = 0;
-		indirect_data.instance_count = 1;
-		indirect_data.first_vertex = 0;
-		indirect_data.vertex_count = blades_num_;
+		auto indirect_data = blade_draw_commands::empty(bucket_capacity_, strip_lods(grass_path::tessellation), STRIP_VERTICES);
 
 		vk::Buffer staging_buffer;
 		vk::DeviceMemory staging_buffer_memory;
@@ -1225,7 +2684,7 @@ private:
 
 		create_buffer(
 			buffer_size,
-			vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer,
+			vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress,
 			vk::MemoryPropertyFlagBits::eDeviceLocal,
 			indirect_draw_commands_buffer_,
 			indirect_draw_commands_buffer_memory_
@@ -1237,10 +2696,204 @@ private:
 
 		copy_buffer(indirect_draw_commands_buffer_, staging_buffer, buffer_size);
 
-		logical_device_.destroyBuffer(staging_buffer);
-		logical_device_.freeMemory(staging_buffer_memory);
+		after_upload([=, this] {
+			logical_device_.destroyBuffer(staging_buffer);
+			logical_device_.freeMemory(staging_buffer_memory);
+		});
+	}
+
+	// sharded like the pool, a slot's states are reset whenever a tile is uploaded into it
+	void create_blade_states_buffer() {
+		state_shards_.resize(shard_count_);
+		state_shard_memories_.resize(shard_count_);
+
+		for (uint32_t shard = 0; shard < shard_count_; ++shard) {
+			create_buffer(
+				sizeof(blade_state) * shard_size(shard),
+				vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress,
+				vk::MemoryPropertyFlagBits::eDeviceLocal,
+				state_shards_[shard],
+				state_shard_memories_[shard]
+			);
+		}
+	}
+
+	void create_awake_blades_buffer() {
+		const vk::DeviceSize buffer_size = sizeof(blade_awake_list) + sizeof(uint32_t) * blades_num_;
+
+		// the pool starts out empty, nothing to simulate before the first cull pass
+		blade_awake_list header{};
+		header.group_count_x = 0;
+		header.group_count_y = 1;
+		header.group_count_z = 1;
+		header.awake_count = 0;
+		header.asleep_count = 0;
+
+		vk::Buffer staging_buffer;
+		vk::DeviceMemory staging_buffer_memory;
+
+		create_buffer(
+			sizeof(header),
+			vk::BufferUsageFlagBits::eTransferSrc,
+			vk::MemoryPropertyFlagBits::eHostCoherent | vk::MemoryPropertyFlagBits::eHostVisible,
+			staging_buffer,
+			staging_buffer_memory
+		);
+
+		create_buffer(
+			buffer_size,
+			vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress,
+			vk::MemoryPropertyFlagBits::eDeviceLocal,
+			awake_blades_buffer_,
+			awake_blades_buffer_memory_
+		);
+
+		auto pstaging_data = logical_device_.mapMemory(staging_buffer_memory, 0, sizeof(header));
+		std::memcpy(pstaging_data, &header, sizeof(header));
+		logical_device_.unmapMemory(staging_buffer_memory);
+
+		copy_buffer(awake_blades_buffer_, staging_buffer, sizeof(header));
+
+		after_upload([=, this] {
+			logical_device_.destroyBuffer(staging_buffer);
+			logical_device_.freeMemory(staging_buffer_memory);
+		});
+	}
+
+	// written once, the buffers it points at live as long as the device
+	void create_blade_address_table() {
+		blade_buffers_address_ = create_address_table(blade_addresses(), blade_address_table_buffer_, blade_address_table_buffer_memory_);
+	}
+
+	vk::DeviceAddress address_of(vk::Buffer buffer) const {
+		return logical_device_.getBufferAddress(vk::BufferDeviceAddressInfo{ buffer });
+	}
+
+	blade_buffer_addresses blade_addresses() const {
+		blade_buffer_addresses addresses{};
+
+		for (uint32_t shard = 0; shard < shard_count_; ++shard) {
+			addresses.blade_shards[shard] = address_of(blade_shards_[shard]);
+			addresses.state_shards[shard] = address_of(state_shards_[shard]);
+		}
+
+		addresses.culled = address_of(culled_blades_buffer);
+		addresses.sorted = address_of(sorted_blades_buffer_);
+		addresses.indirect = address_of(indirect_draw_commands_buffer_);
+		addresses.awake = address_of(awake_blades_buffer_);
+		addresses.stats = address_of(cull_stats_buffer_);
+		addresses.tiles = address_of(tile_table_buffer_);
+		addresses.depth_buckets = address_of(depth_buckets_buffer_);
+
+		return addresses;
+	}
+
+	// a device local copy of addresses, returns the address to push
+	vk::DeviceAddress create_address_table(const blade_buffer_addresses& addresses, vk::Buffer& buffer, vk::DeviceMemory& buffer_memory) {
+		vk::Buffer staging_buffer;
+		vk::DeviceMemory staging_buffer_memory;
+
+		create_buffer(
+			sizeof(addresses),
+			vk::BufferUsageFlagBits::eTransferSrc,
+			vk::MemoryPropertyFlagBits::eHostCoherent | vk::MemoryPropertyFlagBits::eHostVisible,
+			staging_buffer,
+			staging_buffer_memory
+		);
+
+		create_buffer(
+			sizeof(addresses),
+			vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress,
+			vk::MemoryPropertyFlagBits::eDeviceLocal,
+			buffer,
+			buffer_memory
+		);
+
+		auto pstaging_data = logical_device_.mapMemory(staging_buffer_memory, 0, sizeof(addresses));
+		std::memcpy(pstaging_data, &addresses, sizeof(addresses));
+		logical_device_.unmapMemory(staging_buffer_memory);
+
+		copy_buffer(buffer, staging_buffer, sizeof(addresses));
+
+		after_upload([=, this] {
+			logical_device_.destroyBuffer(staging_buffer);
+			logical_device_.freeMemory(staging_buffer_memory);
+		});
+
+		return address_of(buffer);
+	}
+
+public:
+	// GRASS_FP16_REPORT=1: a copy of the blade pool simulated by the fp32 physics kernel
+	// next to the fp16 one. it runs on the same awake list and gets the same tiles, only
+	// its address table points at the copies. see render_system::update_fp16_report
+	void create_fp16_reference() {
+		auto& reference = fp16_reference_.emplace();
+
+		reference.blade_shards.resize(shard_count_);
+		reference.blade_shard_memories.resize(shard_count_);
+		reference.state_shards.resize(shard_count_);
+		reference.state_shard_memories.resize(shard_count_);
+
+		const auto usage = vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress;
+
+		for (uint32_t shard = 0; shard < shard_count_; ++shard) {
+			create_buffer(sizeof(blade) * shard_size(shard), usage, vk::MemoryPropertyFlagBits::eDeviceLocal, reference.blade_shards[shard], reference.blade_shard_memories[shard]);
+			create_buffer(sizeof(blade_state) * shard_size(shard), usage, vk::MemoryPropertyFlagBits::eDeviceLocal, reference.state_shards[shard], reference.state_shard_memories[shard]);
+		}
+
+		auto addresses = blade_addresses();
+
+		for (uint32_t shard = 0; shard < shard_count_; ++shard) {
+			addresses.blade_shards[shard] = address_of(reference.blade_shards[shard]);
+			addresses.state_shards[shard] = address_of(reference.state_shards[shard]);
+		}
+
+		reference.address = create_address_table(addresses, reference.table, reference.table_memory);
+
+		// the live pool, then the reference one, their blades and then their states
+		const vk::DeviceSize readback_size = 2 * (sizeof(blade) + sizeof(blade_state)) * blades_num_;
+
+		create_buffer(
+			readback_size,
+			vk::BufferUsageFlagBits::eTransferDst,
+			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+			reference.readback,
+			reference.readback_memory
+		);
+
+		reference.readback_mapped = logical_device_.mapMemory(reference.readback_memory, 0, readback_size);
+
+		reference.physics = create_physics_pipeline(workgroup_sizes_.physics, false);
+	}
+
+	// only while the compute queue is idle
+	void destroy_fp16_reference() {
+		if (!fp16_reference_) return;
+
+		auto& reference = *fp16_reference_;
+
+		for (uint32_t shard = 0; shard < shard_count_; ++shard) {
+			logical_device_.destroyBuffer(reference.blade_shards[shard]);
+			logical_device_.freeMemory(reference.blade_shard_memories[shard]);
+
+			logical_device_.destroyBuffer(reference.state_shards[shard]);
+			logical_device_.freeMemory(reference.state_shard_memories[shard]);
+		}
+
+		logical_device_.destroyBuffer(reference.table);
+		logical_device_.freeMemory(reference.table_memory);
+
+		logical_device_.destroyBuffer(reference.readback);
+		logical_device_.unmapMemory(reference.readback_memory);
+		logical_device_.freeMemory(reference.readback_memory);
+
+		logical_device_.destroyPipeline(reference.physics);
+
+		fp16_reference_.reset();
 	}
 
+private:
 	void create_uniform_buffers() {
 		vk::DeviceSize buffer_size = sizeof(uniform_buffer_object);
 
@@ -1261,22 +2914,21 @@ private:
 	}
 
 	void create_descriptor_pool() {
-		std::array<vk::DescriptorPoolSize, 4> pool_sizes{};
+		std::array<vk::DescriptorPoolSize, 3> pool_sizes{};
 
 		pool_sizes[0].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
 		pool_sizes[0].type = vk::DescriptorType::eUniformBuffer;
 
-		pool_sizes[1].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
+		// plane textures, the Hi-Z pyramid of the cull pass and of the task shader, the card texture, the scene target
+		pool_sizes[1].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT) + 4;
 		pool_sizes[1].type = vk::DescriptorType::eCombinedImageSampler;
 
 		pool_sizes[2].type = vk::DescriptorType::eStorageBuffer;
 		pool_sizes[2].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
 
-		pool_sizes[3].type = vk::DescriptorType::eStorageBuffer;
-		pool_sizes[3].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-
+		// the grass passes reach their storage buffers through blade_buffer_addresses
 		vk::DescriptorPoolCreateInfo pool_info{};
-		pool_info.maxSets = pool_sizes.size() + 1;
+		pool_info.maxSets = pool_sizes.size() + 4;
 		pool_info.poolSizeCount = pool_sizes.size();
 		pool_info.pPoolSizes = pool_sizes.data();
 
@@ -1335,51 +2987,160 @@ private:
 
 		command_buffers = logical_device_.allocateCommandBuffers(alloc_info);
 
+		// one per frame slot as well, a frame is recorded while the previous one's still runs
 		vk::CommandBufferAllocateInfo compute_alloc_info{};
 		compute_alloc_info.commandPool = command_pool;
 		compute_alloc_info.level = vk::CommandBufferLevel::ePrimary;
-		compute_alloc_info.commandBufferCount = 1;
+		compute_alloc_info.commandBufferCount = MAX_FRAMES_IN_FLIGHT;
 
-		compute_command_buffer_ = logical_device_.allocateCommandBuffers(compute_alloc_info).front();
+		compute_command_buffers_ = logical_device_.allocateCommandBuffers(compute_alloc_info);
 	}
 
+	// the swapchain only takes binary semaphores, everything else waits on the timelines
 	void create_sync_objects() {
 		vk::SemaphoreCreateInfo semaphore_info{};
-		
-		vk::FenceCreateInfo fence_info{};
-		fence_info.flags = vk::FenceCreateFlagBits::eSignaled;
 
 		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
 			image_available_semaphores.emplace_back(logical_device_.createSemaphore(semaphore_info));
 			render_finished_semaphores.emplace_back(logical_device_.createSemaphore(semaphore_info));
-			in_flight_fences.emplace_back(logical_device_.createFence(fence_info));
 		}
 	}
 
+	// one per queue. each submission signals the next value of its queue's timeline, and
+	// whoever reuses what a submission used waits for exactly that value
+	void create_timelines() {
+		vk::StructureChain<vk::SemaphoreCreateInfo, vk::SemaphoreTypeCreateInfo> timeline_info{
+			vk::SemaphoreCreateInfo{},
+			vk::SemaphoreTypeCreateInfo{ vk::SemaphoreType::eTimeline, 0 }
+		};
+
+		graphics_timeline_ = logical_device_.createSemaphore(timeline_info.get<vk::SemaphoreCreateInfo>());
+		compute_timeline_ = logical_device_.createSemaphore(timeline_info.get<vk::SemaphoreCreateInfo>());
+	}
+
+public:
+	void wait_timeline(vk::Semaphore timeline, uint64_t value) const {
+		vk::SemaphoreWaitInfo wait_info{};
+		wait_info.semaphoreCount = 1;
+		wait_info.pSemaphores = &timeline;
+		wait_info.pValues = &value;
+
+		if (logical_device_.waitSemaphores(wait_info, UINT64_MAX) != vk::Result::eSuccess)
+			throw std::runtime_error("failed to wait for a timeline semaphore!");
+	}
+
+	bool timeline_reached(vk::Semaphore timeline, uint64_t value) const {
+		return logical_device_.getSemaphoreCounterValue(timeline) >= value;
+	}
+
+private:
+
 	void cleanup_swapchain() {
+		cleanup_swapchain_resources();
+
+		for (const auto& retired : retired_swapchains_)
+			logical_device_.destroySwapchainKHR(retired.swapchain);
+
+		logical_device_.destroySwapchainKHR(swapchain_);
+	}
+
+	// everything sized by the swapchain extent, the swapchain itself stays
+	void cleanup_swapchain_resources() {
+		for (auto& view : hiz_mip_views_)
+			logical_device_.destroyImageView(view);
+		hiz_mip_views_.clear();
+
+		logical_device_.destroyImageView(hiz_view_);
+		logical_device_.destroyImage(hiz_image_);
+		logical_device_.freeMemory(hiz_image_memory_);
+		logical_device_.destroyDescriptorPool(hiz_descriptor_pool_);
 
 		logical_device_.destroyImageView(depth_image_view);
 		logical_device_.destroyImage(depth_image);
 		logical_device_.freeMemory(depth_image_memory);
 
+		logical_device_.destroyFramebuffer(scene_framebuffer_);
+		logical_device_.destroyImageView(scene_image_view_);
+		logical_device_.destroyImage(scene_image_);
+		logical_device_.freeMemory(scene_image_memory_);
+
 		for (auto& framebuffer : swapchain_framebuffers)
 			logical_device_.destroyFramebuffer(framebuffer);
 
 		for (auto& image_view : swapchain_image_views)
 			logical_device_.destroyImageView(image_view);
 
-		logical_device_.destroySwapchainKHR(swapchain_);
+		swapchain_framebuffers.clear();
+		swapchain_image_views.clear();
 	}
 
-	void create_compute_pipeline() {
-		auto shader_code = read_file("grass.comp.spv");
-		vk::ShaderModule shader_module = create_shader_module(shader_code);
-		
-		vk::PipelineShaderStageCreateInfo shader_stage_info{};
-		shader_stage_info.module = shader_module;
-		shader_stage_info.pName = "main";
-		shader_stage_info.stage = vk::ShaderStageFlagBits::eCompute;
+public:
+	// after a resize, or once presenting reports the swapchain out of date or suboptimal.
+	// only what depends on the extent is rebuilt, pipelines take viewport and scissor
+	// as dynamic state. framebuffer is the window's, as the main thread last saw it.
+	// false while the window is minimized, nothing can be presented then
+	bool recreate_swapchain(vk::Extent2D framebuffer) {
+		framebuffer_extent_ = framebuffer;
+
+		if (framebuffer.width == 0 || framebuffer.height == 0) return false;
+
+		// the extent sized images and the descriptors pointing at them are rebuilt in place,
+		// so the frames submitted so far have to be done with them. the present queue is
+		// not waited for, the old swapchain's images may still be queued for display
+		wait_timeline(graphics_timeline_, graphics_timeline_value_);
+		wait_timeline(compute_timeline_, compute_timeline_value_);
+
+		cleanup_swapchain_resources();
+
+		// the old one hands its images over. nothing tells when the presentation engine is
+		// done with them, so it goes a few frames later, see update_shader_reload
+		const auto old_swapchain = swapchain_;
+		create_swapchain(old_swapchain);
+		retired_swapchains_.push_back({ old_swapchain, graphics_timeline_value_ + MAX_FRAMES_IN_FLIGHT });
+
+		create_image_views();
+		create_depth_resources();
+		create_scene_target();
+		create_framebuffers();
+
+		write_upscale_descriptor();
+
+		// the pyramid matches the depth buffer, it starts out cleared again
+		create_hiz_resources();
+		write_hiz_descriptor();
+
+		return true;
+	}
+
+	// the display's, or the primary monitor's at startup when the device cannot tell
+	std::chrono::nanoseconds refresh_duration() const {
+		if (display_timing_) {
+			VkRefreshCycleDurationGOOGLE duration{};
+
+			if (get_refresh_cycle_duration_(logical_device_, swapchain_, &duration) == VK_SUCCESS && duration.refreshDuration > 0)
+				return std::chrono::nanoseconds(duration.refreshDuration);
+		}
+
+		return std::chrono::nanoseconds(1'000'000'000 / monitor_refresh_rate_);
+	}
+
+	// with display timing only, the frames presented since the last call
+	std::vector<VkPastPresentationTimingGOOGLE> past_presentation_timings() const {
+		if (!display_timing_) return {};
 
+		uint32_t count = 0;
+		if (get_past_presentation_timing_(logical_device_, swapchain_, &count, nullptr) != VK_SUCCESS || count == 0) return {};
+
+		std::vector<VkPastPresentationTimingGOOGLE> timings(count);
+		if (get_past_presentation_timing_(logical_device_, swapchain_, &count, timings.data()) != VK_SUCCESS) return {};
+
+		timings.resize(count);
+		return timings;
+	}
+
+private:
+
+	void create_compute_pipeline() {
 		vk::PipelineLayoutCreateInfo layout_info{};
 		
 		vk::PushConstantRange range{};
@@ -1395,94 +3156,553 @@ private:
 		layout_info.pSetLayouts = descriptor_set_layouts;
 		layout_info.setLayoutCount = sizeof(descriptor_set_layouts) / sizeof(descriptor_set_layouts[0]);
 		
-		compute_pipeline_layout_ = logical_device_.createPipelineLayout(layout_info);
+		if (!compute_pipeline_layout_)
+			compute_pipeline_layout_ = logical_device_.createPipelineLayout(layout_info);
+
+		set_pipeline(compute_pipeline_, create_cull_pipeline(workgroup_sizes_));
+
+		// the physics pass shares the layout and the descriptor set
+		set_pipeline(physics_pipeline_, create_physics_pipeline(workgroup_sizes_.physics, blade_fp16_));
+	}
+
+	// grass.comp with local_size_x of sizes.cull. it sizes the physics dispatch of the
+	// next frame, so it has to know that pass's workgroup size as well
+	vk::Pipeline create_cull_pipeline(const compute_workgroup_sizes& sizes) {
+		const auto grass_shader_code = shader_code(cull_shader());
+		vk::ShaderModule shader_module = create_shader_module(grass_shader_code);
+
+		struct {
+			uint32_t rest_frames_to_sleep = tools::params::REST_FRAMES_TO_SLEEP;
+			float lod_mid_distance = tools::params::LOD_MID_DISTANCE;
+			float lod_far_distance = tools::params::LOD_FAR_DISTANCE;
+			float card_fade_start = tools::params::CARD_FADE_START;
+			float card_fade_end = tools::params::CARD_FADE_END;
+			uint32_t blades_per_tile = tools::params::BLADES_PER_TILE;
+			uint32_t blades_per_shard;
+			uint32_t tile_slots = tools::params::STREAM_POOL_SLOTS;
+			uint32_t bucket_capacity;
+			uint32_t workgroup_size;
+			uint32_t physics_workgroup_size;
+		} cull_constants;
+
+		cull_constants.blades_per_shard = blades_per_shard_;
+		cull_constants.bucket_capacity = bucket_capacity_;
+		cull_constants.workgroup_size = sizes.cull;
+		cull_constants.physics_workgroup_size = sizes.physics;
+
+		vk::SpecializationMapEntry cull_entries[] = {
+			{ 0, offsetof(decltype(cull_constants), rest_frames_to_sleep), sizeof(uint32_t) },
+			{ 1, offsetof(decltype(cull_constants), lod_mid_distance), sizeof(float) },
+			{ 2, offsetof(decltype(cull_constants), lod_far_distance), sizeof(float) },
+			{ 3, offsetof(decltype(cull_constants), card_fade_start), sizeof(float) },
+			{ 4, offsetof(decltype(cull_constants), card_fade_end), sizeof(float) },
+			{ 5, offsetof(decltype(cull_constants), blades_per_tile), sizeof(uint32_t) },
+			{ 6, offsetof(decltype(cull_constants), blades_per_shard), sizeof(uint32_t) },
+			{ 7, offsetof(decltype(cull_constants), tile_slots), sizeof(uint32_t) },
+			{ 8, offsetof(decltype(cull_constants), bucket_capacity), sizeof(uint32_t) },
+			{ 9, offsetof(decltype(cull_constants), workgroup_size), sizeof(uint32_t) },
+			{ 10, offsetof(decltype(cull_constants), physics_workgroup_size), sizeof(uint32_t) }
+		};
+
+		vk::SpecializationInfo cull_specialization_info{};
+		cull_specialization_info.mapEntryCount = sizeof(cull_entries) / sizeof(cull_entries[0]);
+		cull_specialization_info.pMapEntries = cull_entries;
+		cull_specialization_info.dataSize = sizeof(cull_constants);
+		cull_specialization_info.pData = &cull_constants;
 
 		vk::ComputePipelineCreateInfo create_info{};
 		create_info.layout = compute_pipeline_layout_;
-		create_info.stage = shader_stage_info;
+		create_info.stage.module = shader_module;
+		create_info.stage.pName = "main";
+		create_info.stage.stage = vk::ShaderStageFlagBits::eCompute;
+		create_info.stage.pSpecializationInfo = &cull_specialization_info;
+
+		auto pipeline = logical_device_.createComputePipeline(pipeline_cache_, create_info).value;
+
+		logical_device_.destroyShaderModule(shader_module);
+
+		return pipeline;
+	}
+
+	// fp16 only if the device and the compiled shaders allow, the fp32 one otherwise
+	vk::Pipeline create_physics_pipeline(uint32_t workgroup_size, bool fp16) {
+		const auto physics_shader_code = shader_code(fp16 ? blade_shader("grass_physics.comp.spv") : "grass_physics.comp.spv");
+		vk::ShaderModule physics_shader_module = create_shader_module(physics_shader_code);
+
+		struct {
+			uint32_t rest_frames_to_sleep = tools::params::REST_FRAMES_TO_SLEEP;
+			float rest_threshold = tools::params::REST_THRESHOLD;
+			uint32_t blades_per_shard;
+			uint32_t workgroup_size;
+		} physics_constants;
+
+		physics_constants.blades_per_shard = blades_per_shard_;
+		physics_constants.workgroup_size = workgroup_size;
+
+		vk::SpecializationMapEntry physics_entries[] = {
+			{ 0, offsetof(decltype(physics_constants), rest_frames_to_sleep), sizeof(uint32_t) },
+			{ 1, offsetof(decltype(physics_constants), rest_threshold), sizeof(float) },
+			{ 2, offsetof(decltype(physics_constants), blades_per_shard), sizeof(uint32_t) },
+			{ 3, offsetof(decltype(physics_constants), workgroup_size), sizeof(uint32_t) }
+		};
+
+		vk::SpecializationInfo physics_specialization_info{};
+		physics_specialization_info.mapEntryCount = sizeof(physics_entries) / sizeof(physics_entries[0]);
+		physics_specialization_info.pMapEntries = physics_entries;
+		physics_specialization_info.dataSize = sizeof(physics_constants);
+		physics_specialization_info.pData = &physics_constants;
+
+		vk::ComputePipelineCreateInfo create_info{};
+		create_info.layout = compute_pipeline_layout_;
+		create_info.stage.module = physics_shader_module;
+		create_info.stage.pName = "main";
+		create_info.stage.stage = vk::ShaderStageFlagBits::eCompute;
+		create_info.stage.pSpecializationInfo = &physics_specialization_info;
+
+		auto pipeline = logical_device_.createComputePipeline(pipeline_cache_, create_info).value;
+
+		logical_device_.destroyShaderModule(physics_shader_module);
 
-		compute_pipeline_ = logical_device_.createComputePipeline(nullptr, create_info).value;
+		return pipeline;
+	}
+
+	// the sizes tuned for this device and driver before, if any. GRASS_RETUNE=1 tunes anew
+	void load_workgroup_sizes() {
+		const auto properties = physical_device_.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceIDProperties>();
+		const auto& id = properties.get<vk::PhysicalDeviceIDProperties>();
+
+		std::copy(id.deviceUUID.begin(), id.deviceUUID.end(), device_uuid_.begin());
+		driver_version_ = properties.get<vk::PhysicalDeviceProperties2>().properties.driverVersion;
+
+		if (std::getenv("GRASS_RETUNE")) return;
+
+		if (const auto sizes = workgroup_cache::load(WORKGROUP_CACHE_PATH, device_uuid_, driver_version_)) {
+			workgroup_sizes_ = *sizes;
+			workgroup_sizes_tuned_ = true;
+		}
+	}
+
+public:
+	// powers of two from 32 up to what the device allows, 1024 at most. ascending, so an
+	// awake list sized by one candidate never undersizes the next one's physics dispatch
+	std::vector<uint32_t> workgroup_size_candidates() const {
+		const auto limits = physical_device_.getProperties().limits;
+		const uint32_t largest = std::min({ 1024u, limits.maxComputeWorkGroupSize[0], limits.maxComputeWorkGroupInvocations });
+
+		std::vector<uint32_t> sizes;
+		for (uint32_t size = COMPUTE_WORKGROUP_SIZE; size <= largest; size *= 2)
+			sizes.push_back(size);
+
+		return sizes;
+	}
+
+	// both kernels of every candidate, built on the workers while the tuner warms up
+	void build_tuning_pipelines(const std::vector<uint32_t>& candidates) {
+		tuning_pipelines_.resize(candidates.size());
+
+		// the chunks are background tasks as well, see job_system::submit
+		tuning_build_ = jobs_.submit_background("build tuning pipelines", [this, candidates] {
+			jobs_.parallel_for("tuning pipeline", static_cast<uint32_t>(candidates.size()), 1, [&](uint32_t first, uint32_t last) {
+				for (uint32_t i = first; i < last; ++i)
+					tuning_pipelines_[i] = { create_cull_pipeline({ candidates[i], candidates[i] }), create_physics_pipeline(candidates[i], blade_fp16_) };
+			});
+		});
+	}
+
+	// only while the compute queue is idle
+	void destroy_tuning_pipelines() {
+		if (tuning_build_) {
+			try {
+				jobs_.wait(tuning_build_);
+			}
+			catch (const std::exception&) {}
+
+			tuning_build_.reset();
+		}
+
+		for (const auto& candidate : tuning_pipelines_) {
+			if (candidate.cull) logical_device_.destroyPipeline(candidate.cull);
+			if (candidate.physics) logical_device_.destroyPipeline(candidate.physics);
+		}
+
+		tuning_pipelines_.clear();
+	}
+
+	// between frames, once the last compute submission is done. the replaced kernels go the
+	// way of reloaded ones, and the sizes are kept for the next run on this device
+	void set_workgroup_sizes(const compute_workgroup_sizes& sizes) {
+		// a reload in flight reads the sizes, and would swap in kernels of the old ones after this
+		if (reload_) finish_reload();
+
+		workgroup_sizes_ = sizes;
+		workgroup_sizes_tuned_ = true;
+
+		retired_pipelines_.push_back({ compute_pipeline_, graphics_timeline_value_ });
+		retired_pipelines_.push_back({ physics_pipeline_, graphics_timeline_value_ });
+
+		compute_pipeline_ = create_cull_pipeline(sizes);
+		physics_pipeline_ = create_physics_pipeline(sizes.physics, blade_fp16_);
+
+		try {
+			workgroup_cache::store(WORKGROUP_CACHE_PATH, device_uuid_, driver_version_, sizes);
+		}
+		catch (const std::exception& error) {
+			std::cerr << "the tuned workgroup sizes are not kept: " << error.what() << std::endl;
+		}
+	}
+
+private:
+	void create_sort_pipelines() {
+		// no descriptors, the buffers come with blade_sort_push_data
+		vk::PushConstantRange range{};
+		range.offset = 0;
+		range.size = sizeof(blade_sort_push_data);
+		range.stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+		vk::PipelineLayoutCreateInfo layout_info{};
+		layout_info.pushConstantRangeCount = 1;
+		layout_info.pPushConstantRanges = &range;
+
+		if (!sort_pipeline_layout_)
+			sort_pipeline_layout_ = logical_device_.createPipelineLayout(layout_info);
+
+		const auto sort_shader_code = shader_code("grass_sort.comp.spv");
+		vk::ShaderModule shader_module = create_shader_module(sort_shader_code);
+
+		// histogram, prefix sum and scatter only differ in the sort_pass constant
+		for (uint32_t pass = 0; pass < sort_pipelines_.size(); ++pass) {
+			vk::SpecializationMapEntry pass_entry{ 0, 0, sizeof(uint32_t) };
+
+			vk::SpecializationInfo specialization_info{};
+			specialization_info.mapEntryCount = 1;
+			specialization_info.pMapEntries = &pass_entry;
+			specialization_info.dataSize = sizeof(pass);
+			specialization_info.pData = &pass;
+
+			vk::ComputePipelineCreateInfo create_info{};
+			create_info.layout = sort_pipeline_layout_;
+			create_info.stage.module = shader_module;
+			create_info.stage.pName = "main";
+			create_info.stage.stage = vk::ShaderStageFlagBits::eCompute;
+			create_info.stage.pSpecializationInfo = &specialization_info;
+
+			set_pipeline(sort_pipelines_[pass], logical_device_.createComputePipeline(pipeline_cache_, create_info).value);
+		}
 
 		logical_device_.destroyShaderModule(shader_module);
 	}
 
+	void create_query_pools() {
+		// the grass kernels are timed while their workgroup sizes are tuned
+		const auto limits = physical_device_.getProperties().limits;
+
+		if (limits.timestampComputeAndGraphics) {
+			vk::QueryPoolCreateInfo timestamp_info{};
+			timestamp_info.queryType = vk::QueryType::eTimestamp;
+			timestamp_info.queryCount = COMPUTE_TIMESTAMPS;
+
+			compute_timestamp_pool_ = logical_device_.createQueryPool(timestamp_info);
+			timestamp_period_ = limits.timestampPeriod;
+		}
+
+		// the scene pass, begin and end per frame in flight, for the dynamic resolution
+		if (limits.timestampComputeAndGraphics) {
+			vk::QueryPoolCreateInfo scene_timestamp_info{};
+			scene_timestamp_info.queryType = vk::QueryType::eTimestamp;
+			scene_timestamp_info.queryCount = 2 * MAX_FRAMES_IN_FLIGHT;
+
+			scene_timestamp_pool_ = logical_device_.createQueryPool(scene_timestamp_info);
+		}
+
+		// fragment invocations of the grass draw, one query per frame in flight
+		if (!physical_device_.getFeatures().pipelineStatisticsQuery) return;
+
+		vk::QueryPoolCreateInfo pool_info{};
+		pool_info.queryType = vk::QueryType::ePipelineStatistics;
+		pool_info.queryCount = MAX_FRAMES_IN_FLIGHT;
+		pool_info.pipelineStatistics = vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations;
+
+		pipeline_statistics_query_pool_ = logical_device_.createQueryPool(pool_info);
+	}
+
 	void get_compute_queue() {
 		compute_queue_ = logical_device_.getQueue(0, 0);
 	}
 
 	void create_compute_descritpor_set_layout() {
-		vk::DescriptorSetLayoutBinding all_blades_binding{};
-		all_blades_binding.binding = 0;
-		all_blades_binding.descriptorCount = 1;
-		all_blades_binding.descriptorType = vk::DescriptorType::eStorageBuffer;
-		all_blades_binding.stageFlags = vk::ShaderStageFlagBits::eCompute;
-
-		vk::DescriptorSetLayoutBinding culled_blades_binding{};
-		culled_blades_binding.binding = 1;
-		culled_blades_binding.descriptorCount = 1;
-		culled_blades_binding.descriptorType = vk::DescriptorType::eStorageBuffer;
-		culled_blades_binding.stageFlags = vk::ShaderStageFlagBits::eCompute;
-
-		vk::DescriptorSetLayoutBinding indirect_draw_params_binding{};
-		indirect_draw_params_binding.binding = 2;
-		indirect_draw_params_binding.descriptorCount = 1;
-		indirect_draw_params_binding.descriptorType = vk::DescriptorType::eStorageBuffer;
-		indirect_draw_params_binding.stageFlags = vk::ShaderStageFlagBits::eCompute;
-
-		vk::DescriptorSetLayoutBinding bindings[] = { 
-			all_blades_binding, culled_blades_binding, indirect_draw_params_binding 
-		};
+		// the rest comes with the push constants, see blade_buffer_addresses
+		vk::DescriptorSetLayoutBinding hiz_binding{};
+		hiz_binding.binding = 0;
+		hiz_binding.descriptorCount = 1;
+		hiz_binding.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+		hiz_binding.stageFlags = vk::ShaderStageFlagBits::eCompute;
 
 		vk::DescriptorSetLayoutCreateInfo create_info{};
-		create_info.bindingCount = sizeof(bindings) / sizeof(bindings[0]);
-		create_info.pBindings = bindings;
+		create_info.bindingCount = 1;
+		create_info.pBindings = &hiz_binding;
 
 		compute_set_layout_ = logical_device_.createDescriptorSetLayout(create_info);
 	}
 
 	void create_compute_descriptor_sets() {
-		vk::DescriptorSetLayout layouts[] = { compute_set_layout_ };
 		vk::DescriptorSetAllocateInfo alloc_info{ descriptor_pool, 1, &compute_set_layout_ };
 	
 		compute_descriptor_sets_ = logical_device_.allocateDescriptorSets(alloc_info);
 
-		std::vector<vk::WriteDescriptorSet> descriptor_writes(3);
+		write_hiz_descriptor();
+	}
 
-		vk::DescriptorBufferInfo all_blades{};
-		all_blades.buffer = blades_buffer;
-		all_blades.range = sizeof(blade) * blades_num_;
+	// the pyramid is recreated with the swapchain, so is this binding
+	void write_hiz_descriptor() {
+		vk::DescriptorImageInfo hiz_info{};
+		hiz_info.sampler = hiz_sampler_;
+		hiz_info.imageView = hiz_view_;
+		hiz_info.imageLayout = vk::ImageLayout::eGeneral;
 
-		descriptor_writes[0].descriptorCount = 1;
-		descriptor_writes[0].descriptorType = vk::DescriptorType::eStorageBuffer;
-		descriptor_writes[0].dstBinding = 0;
-		descriptor_writes[0].dstSet = compute_descriptor_sets_[0];
-		descriptor_writes[0].pBufferInfo = &all_blades;
+		vk::WriteDescriptorSet hiz_write{};
+		hiz_write.descriptorCount = 1;
+		hiz_write.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+		hiz_write.dstBinding = 0;
+		hiz_write.dstSet = compute_descriptor_sets_[0];
+		hiz_write.pImageInfo = &hiz_info;
 
-		vk::DescriptorBufferInfo culled_blades{};
-		culled_blades.buffer = culled_blades_buffer;
-		culled_blades.range = sizeof(blade) * blades_num_;
+		logical_device_.updateDescriptorSets(hiz_write, {});
 
-		descriptor_writes[1].descriptorCount = 1;
-		descriptor_writes[1].descriptorType = vk::DescriptorType::eStorageBuffer;
-		descriptor_writes[1].dstBinding = 1;
-		descriptor_writes[1].dstSet = compute_descriptor_sets_[0];
-		descriptor_writes[1].pBufferInfo = &culled_blades;
+		if (!mesh_descriptor_set_) return;
+
+		hiz_write.dstSet = mesh_descriptor_set_;
+
+		logical_device_.updateDescriptorSets(hiz_write, {});
+	}
+
+	void create_mesh_descriptor_set() {
+		if (!mesh_shaders_) return;
+
+		// its only binding, the Hi-Z pyramid, is written along with the cull pass one
+		vk::DescriptorSetAllocateInfo alloc_info{ descriptor_pool, 1, &mesh_set_layout_ };
+		mesh_descriptor_set_ = logical_device_.allocateDescriptorSets(alloc_info).front();
+	}
+
+	void create_cull_stats_buffer() {
+		// reset by the compute command buffer every frame
+		create_buffer(
+			sizeof(blade_cull_stats),
+			vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress,
+			vk::MemoryPropertyFlagBits::eDeviceLocal,
+			cull_stats_buffer_,
+			cull_stats_buffer_memory_
+		);
+	}
+
+	// a frame_stats_block per frame in flight, mapped for good. cached memory where there
+	// is some, the CPU reads it and never writes, and it is invalidated before every read
+	void create_stats_readback() {
+		const vk::DeviceSize atom = physical_device_.getProperties().limits.nonCoherentAtomSize;
+		stats_readback_stride_ = (sizeof(frame_stats_block) + atom - 1) / atom * atom;
+
+		vk::BufferCreateInfo buffer_info{};
+		buffer_info.size = stats_readback_stride_ * MAX_FRAMES_IN_FLIGHT;
+		buffer_info.usage = vk::BufferUsageFlagBits::eTransferDst;
+		buffer_info.sharingMode = vk::SharingMode::eExclusive;
+
+		stats_readback_buffer_ = logical_device_.createBuffer(buffer_info);
+
+		const auto memory_requirements = logical_device_.getBufferMemoryRequirements(stats_readback_buffer_);
+		const auto memory_properties = physical_device_.getMemoryProperties();
+
+		// find_memory_type takes any of the flags, both are needed here
+		const auto find_type = [&](vk::MemoryPropertyFlags flags) -> std::optional<uint32_t> {
+			for (uint32_t i = 0; i < memory_properties.memoryTypeCount; ++i)
+				if (memory_requirements.memoryTypeBits & (1 << i) && (memory_properties.memoryTypes[i].propertyFlags & flags) == flags)
+					return i;
+
+			return std::nullopt;
+		};
+
+		auto type = find_type(vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCached);
+		if (!type) type = find_type(vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent);
+		if (!type) throw std::runtime_error("failed to find host visible memory for the stats readback!");
+
+		stats_readback_coherent_ = static_cast<bool>(memory_properties.memoryTypes[*type].propertyFlags & vk::MemoryPropertyFlagBits::eHostCoherent);
+
+		stats_readback_buffer_memory_ = logical_device_.allocateMemory(vk::MemoryAllocateInfo{ memory_requirements.size, *type });
+		logical_device_.bindBufferMemory(stats_readback_buffer_, stats_readback_buffer_memory_, 0);
+
+		stats_readback_mapped_ = logical_device_.mapMemory(stats_readback_buffer_memory_, 0, VK_WHOLE_SIZE);
+	}
+
+public:
+	vk::DeviceSize stats_readback_offset(uint32_t frame) const {
+		return stats_readback_stride_ * frame;
+	}
+
+	// only once the compute work that filled the frame slot's block is done
+	frame_stats_block read_stats_block(uint32_t frame) const {
+		if (!stats_readback_coherent_)
+			logical_device_.invalidateMappedMemoryRanges(vk::MappedMemoryRange{ stats_readback_buffer_memory_, stats_readback_offset(frame), stats_readback_stride_ });
+
+		frame_stats_block block;
+		std::memcpy(&block, static_cast<const std::byte*>(stats_readback_mapped_) + stats_readback_offset(frame), sizeof(block));
+
+		return block;
+	}
+
+private:
+
+	void create_hiz_pipeline() {
+		vk::DescriptorSetLayoutBinding src_binding{};
+		src_binding.binding = 0;
+		src_binding.descriptorCount = 1;
+		src_binding.descriptorType = vk::DescriptorType::eCombinedImageSampler;
+		src_binding.stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+		vk::DescriptorSetLayoutBinding dst_binding{};
+		dst_binding.binding = 1;
+		dst_binding.descriptorCount = 1;
+		dst_binding.descriptorType = vk::DescriptorType::eStorageImage;
+		dst_binding.stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+		vk::DescriptorSetLayoutBinding bindings[] = { src_binding, dst_binding };
+
+		vk::DescriptorSetLayoutCreateInfo set_layout_info{};
+		set_layout_info.bindingCount = sizeof(bindings) / sizeof(bindings[0]);
+		set_layout_info.pBindings = bindings;
+
+		if (!hiz_set_layout_)
+			hiz_set_layout_ = logical_device_.createDescriptorSetLayout(set_layout_info);
+
+		vk::PipelineLayoutCreateInfo layout_info{};
+		layout_info.setLayoutCount = 1;
+		layout_info.pSetLayouts = &hiz_set_layout_;
+
+		if (!hiz_pipeline_layout_)
+			hiz_pipeline_layout_ = logical_device_.createPipelineLayout(layout_info);
+
+		const auto hiz_shader_code = shader_code("hiz.comp.spv");
+		vk::ShaderModule shader_module = create_shader_module(hiz_shader_code);
+
+		vk::ComputePipelineCreateInfo create_info{};
+		create_info.layout = hiz_pipeline_layout_;
+		create_info.stage.module = shader_module;
+		create_info.stage.pName = "main";
+		create_info.stage.stage = vk::ShaderStageFlagBits::eCompute;
 
-		vk::DescriptorBufferInfo indirect_params{};
-		indirect_params.buffer = indirect_draw_commands_buffer_;
-		indirect_params.range = sizeof(blade_draw_indirect);
+		set_pipeline(hiz_pipeline_, logical_device_.createComputePipeline(pipeline_cache_, create_info).value);
 
-		descriptor_writes[2].descriptorCount = 1;
-		descriptor_writes[2].descriptorType = vk::DescriptorType::eStorageBuffer;
-		descriptor_writes[2].dstBinding = 2;
-		descriptor_writes[2].dstSet = compute_descriptor_sets_[0];
-		descriptor_writes[2].pBufferInfo = &indirect_params;
+		logical_device_.destroyShaderModule(shader_module);
+
+		// texelFetch only, filtering would break the conservative max
+		vk::SamplerCreateInfo sampler_info{};
+		sampler_info.magFilter = vk::Filter::eNearest;
+		sampler_info.minFilter = vk::Filter::eNearest;
+		sampler_info.mipmapMode = vk::SamplerMipmapMode::eNearest;
+		sampler_info.addressModeU = vk::SamplerAddressMode::eClampToEdge;
+		sampler_info.addressModeV = vk::SamplerAddressMode::eClampToEdge;
+		sampler_info.addressModeW = vk::SamplerAddressMode::eClampToEdge;
+		sampler_info.maxLod = VK_LOD_CLAMP_NONE;
+
+		if (!hiz_sampler_)
+			hiz_sampler_ = logical_device_.createSampler(sampler_info);
+	}
+
+	void create_hiz_resources() {
+		const auto width = swapchain_extent.width;
+		const auto height = swapchain_extent.height;
+
+		hiz_levels_ = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+
+		create_image(
+			width,
+			height,
+			vk::Format::eR32Sfloat,
+			vk::ImageTiling::eOptimal,
+			vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst,
+			vk::MemoryPropertyFlagBits::eDeviceLocal,
+			hiz_image_,
+			hiz_image_memory_,
+			hiz_levels_
+		);
+
+		hiz_view_ = create_image_view(hiz_image_, vk::Format::eR32Sfloat, vk::ImageAspectFlagBits::eColor, 0, hiz_levels_);
+
+		for (uint32_t level = 0; level < hiz_levels_; ++level)
+			hiz_mip_views_.emplace_back(create_image_view(hiz_image_, vk::Format::eR32Sfloat, vk::ImageAspectFlagBits::eColor, level, 1));
+
+		// the pyramid lives in the general layout, cleared to the far plane
+		// so nothing gets occluded before the first frame is rendered
+		auto commands = begin_single_time_commands();
+
+		vk::ImageSubresourceRange whole_pyramid{ vk::ImageAspectFlagBits::eColor, 0, hiz_levels_, 0, 1 };
+
+		vk::ImageMemoryBarrier to_general{};
+		to_general.image = hiz_image_;
+		to_general.oldLayout = vk::ImageLayout::eUndefined;
+		to_general.newLayout = vk::ImageLayout::eGeneral;
+		to_general.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		to_general.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		to_general.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+		to_general.subresourceRange = whole_pyramid;
+
+		commands.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, {}, {}, {}, to_general);
+		commands.clearColorImage(hiz_image_, vk::ImageLayout::eGeneral, vk::ClearColorValue{ 1.0f, 1.0f, 1.0f, 1.0f }, whole_pyramid);
+
+		end_single_time_commads(commands);
+
+		// one set per level: level 0 reads the depth buffer, the others the level above
+		std::array<vk::DescriptorPoolSize, 2> pool_sizes{};
+		pool_sizes[0].type = vk::DescriptorType::eCombinedImageSampler;
+		pool_sizes[0].descriptorCount = hiz_levels_;
+		pool_sizes[1].type = vk::DescriptorType::eStorageImage;
+		pool_sizes[1].descriptorCount = hiz_levels_;
+
+		vk::DescriptorPoolCreateInfo pool_info{};
+		pool_info.maxSets = hiz_levels_;
+		pool_info.poolSizeCount = pool_sizes.size();
+		pool_info.pPoolSizes = pool_sizes.data();
+
+		hiz_descriptor_pool_ = logical_device_.createDescriptorPool(pool_info);
+
+		std::vector<vk::DescriptorSetLayout> layouts(hiz_levels_, hiz_set_layout_);
 
-		logical_device_.updateDescriptorSets(descriptor_writes, {});
+		vk::DescriptorSetAllocateInfo alloc_info{};
+		alloc_info.descriptorPool = hiz_descriptor_pool_;
+		alloc_info.descriptorSetCount = hiz_levels_;
+		alloc_info.pSetLayouts = layouts.data();
+
+		hiz_descriptor_sets_ = logical_device_.allocateDescriptorSets(alloc_info);
+
+		for (uint32_t level = 0; level < hiz_levels_; ++level) {
+			vk::DescriptorImageInfo src_info{};
+			src_info.sampler = hiz_sampler_;
+			src_info.imageView = level == 0 ? depth_image_view : hiz_mip_views_[level - 1];
+			src_info.imageLayout = level == 0 ? vk::ImageLayout::eShaderReadOnlyOptimal : vk::ImageLayout::eGeneral;
+
+			vk::DescriptorImageInfo dst_info{};
+			dst_info.imageView = hiz_mip_views_[level];
+			dst_info.imageLayout = vk::ImageLayout::eGeneral;
+
+			std::array<vk::WriteDescriptorSet, 2> descriptor_writes{};
+
+			descriptor_writes[0].dstSet = hiz_descriptor_sets_[level];
+			descriptor_writes[0].dstBinding = 0;
+			descriptor_writes[0].descriptorCount = 1;
+			descriptor_writes[0].descriptorType = vk::DescriptorType::eCombinedImageSampler;
+			descriptor_writes[0].pImageInfo = &src_info;
+
+			descriptor_writes[1].dstSet = hiz_descriptor_sets_[level];
+			descriptor_writes[1].dstBinding = 1;
+			descriptor_writes[1].descriptorCount = 1;
+			descriptor_writes[1].descriptorType = vk::DescriptorType::eStorageImage;
+			descriptor_writes[1].pImageInfo = &dst_info;
+
+			logical_device_.updateDescriptorSets(descriptor_writes, {});
+		}
 	}
 
 public:
 	GLFWwindow* window_ = nullptr;
+	vk::Extent2D framebuffer_extent_; // see init_window
+	int monitor_refresh_rate_ = 60;
 
 	vk::Instance instance_ = nullptr;
 	vk::SurfaceKHR surface_;
@@ -1513,11 +3733,16 @@ public:
 
 	vk::CommandPool command_pool; //for drawing
 	std::vector<vk::CommandBuffer> command_buffers;
-	vk::CommandBuffer compute_command_buffer_;
+	std::vector<vk::CommandBuffer> compute_command_buffers_;
 
 	std::vector<vk::Semaphore> image_available_semaphores; //an image has been acquired from the swapchain and is ready for rendering
 	std::vector<vk::Semaphore> render_finished_semaphores; //rendering has finished 
-	std::vector<vk::Fence> in_flight_fences; //to make sure only one frame is rendering at a time
+
+	// see create_timelines. the values are the last ones submitted
+	vk::Semaphore graphics_timeline_;
+	uint64_t graphics_timeline_value_ = 0;
+	vk::Semaphore compute_timeline_;
+	uint64_t compute_timeline_value_ = 0;
 
 	uint32_t current_frame;
 	
@@ -1556,10 +3781,64 @@ public:
 	vk::PipelineLayout grass_pipeline_layout_;
 
 	vk::Pipeline compute_pipeline_;
-	vk::Pipeline grass_pipeline_;
+	vk::Pipeline physics_pipeline_;
+
+	// the grass kernels' local_size_x, see workgroup_tuner.hpp
+	compute_workgroup_sizes workgroup_sizes_{ COMPUTE_WORKGROUP_SIZE, COMPUTE_WORKGROUP_SIZE };
+	bool workgroup_sizes_tuned_ = false; // for this device and driver, on this run or an earlier one
+	workgroup_cache::device_uuid device_uuid_{};
+	uint32_t driver_version_ = 0;
 
-	vk::Buffer blades_buffer;
-	vk::DeviceMemory blades_buffer_memory;
+	struct compute_pipelines {
+		vk::Pipeline cull;
+		vk::Pipeline physics;
+	};
+
+	std::vector<compute_pipelines> tuning_pipelines_; // one per candidate while tuning
+	job_system::handle tuning_build_;
+
+	vk::QueryPool compute_timestamp_pool_; // none without timestampComputeAndGraphics
+	vk::QueryPool scene_timestamp_pool_; // the same, see create_query_pools
+	float timestamp_period_ = 0.0f; // nanoseconds per tick
+	std::array<vk::Pipeline, far_lod> grass_tessellation_pipelines_; // near and mid lods
+	std::array<vk::Pipeline, lod_count> grass_strip_pipelines_;
+
+	vk::PhysicalDeviceVulkan12Features vulkan12_features_;
+
+	// shaderFloat16 and BLADE_FP16, see blade_shader
+	bool blade_fp16_ = false;
+
+	// CULL_STATS and subgroup ballots in compute, see cull_shader
+	bool cull_stats_ = false;
+
+	// VK_EXT_mesh_shader with task shaders, grass_path::mesh is unavailable without it
+	bool mesh_shaders_ = false;
+	PFN_vkCmdDrawMeshTasksEXT cmd_draw_mesh_tasks_ = nullptr;
+
+	// GRASS_PRESENT or PRESENT_POLICY, the swapchain is recreated when it changes
+	present_policy present_policy_ = parse_present_policy(std::getenv("GRASS_PRESENT") ? std::getenv("GRASS_PRESENT") : "").value_or(tools::params::PRESENT_POLICY);
+	vk::PresentModeKHR present_mode_ = vk::PresentModeKHR::eFifo; // what the policy got
+
+	// VK_GOOGLE_display_timing, frames get a present ID and their actual present time is reported
+	bool display_timing_ = false;
+	PFN_vkGetRefreshCycleDurationGOOGLE get_refresh_cycle_duration_ = nullptr;
+	PFN_vkGetPastPresentationTimingGOOGLE get_past_presentation_timing_ = nullptr;
+
+	vk::DescriptorSetLayout mesh_set_layout_;
+	vk::DescriptorSet mesh_descriptor_set_;
+	vk::PipelineLayout mesh_pipeline_layout_;
+	vk::Pipeline mesh_pipeline_;
+
+	// the pool of streamed tiles, blades_per_shard_ blades a buffer
+	std::vector<vk::Buffer> blade_shards_;
+	std::vector<vk::DeviceMemory> blade_shard_memories_;
+
+	vk::Buffer tile_table_buffer_;
+	vk::DeviceMemory tile_table_buffer_memory_;
+
+	vk::Buffer tile_staging_buffer_;
+	vk::DeviceMemory tile_staging_buffer_memory_;
+	void* tile_staging_mapped_ = nullptr;
 
 	vk::Buffer culled_blades_buffer;
 	vk::DeviceMemory culled_blades_buffer_memory;
@@ -1567,5 +3846,170 @@ public:
 	vk::Buffer indirect_draw_commands_buffer_;
 	vk::DeviceMemory indirect_draw_commands_buffer_memory_;
 
+	std::vector<vk::Buffer> state_shards_;
+	std::vector<vk::DeviceMemory> state_shard_memories_;
+
+	// compacted indices of the blades the physics pass has to simulate
+	vk::Buffer awake_blades_buffer_;
+	vk::DeviceMemory awake_blades_buffer_memory_;
+
+	// culled_blades_buffer ordered front to back by grass_sort.comp
+	vk::Buffer sorted_blades_buffer_;
+	vk::DeviceMemory sorted_blades_buffer_memory_;
+
+	vk::Buffer depth_buckets_buffer_;
+	vk::DeviceMemory depth_buckets_buffer_memory_;
+
+	vk::PipelineLayout sort_pipeline_layout_;
+	std::array<vk::Pipeline, 3> sort_pipelines_;
+
+	// null if the device has no pipelineStatisticsQuery
+	vk::QueryPool pipeline_statistics_query_pool_;
+
+	vk::Buffer cull_stats_buffer_;
+	vk::DeviceMemory cull_stats_buffer_memory_;
+
+	// per frame slot, see create_stats_readback
+	vk::Buffer stats_readback_buffer_;
+	vk::DeviceMemory stats_readback_buffer_memory_;
+	void* stats_readback_mapped_ = nullptr;
+	vk::DeviceSize stats_readback_stride_ = 0;
+	bool stats_readback_coherent_ = true;
+
+	// blade_buffer_addresses, blade_buffers_address_ is pushed to every grass pass
+	vk::Buffer blade_address_table_buffer_;
+	vk::DeviceMemory blade_address_table_buffer_memory_;
+	vk::DeviceAddress blade_buffers_address_ = 0;
+
+	struct fp16_reference {
+		std::vector<vk::Buffer> blade_shards;
+		std::vector<vk::DeviceMemory> blade_shard_memories;
+		std::vector<vk::Buffer> state_shards;
+		std::vector<vk::DeviceMemory> state_shard_memories;
+
+		vk::Buffer table;
+		vk::DeviceMemory table_memory;
+		vk::DeviceAddress address = 0;
+
+		vk::Buffer readback;
+		vk::DeviceMemory readback_memory;
+		void* readback_mapped = nullptr;
+
+		vk::Pipeline physics; // fp32
+	};
+
+	// only while GRASS_FP16_REPORT runs, see create_fp16_reference
+	std::optional<fp16_reference> fp16_reference_;
+
+	// hierarchical depth, rebuilt from depth_image at the end of every frame
+	vk::Image hiz_image_;
+	vk::DeviceMemory hiz_image_memory_;
+	vk::ImageView hiz_view_;
+	std::vector<vk::ImageView> hiz_mip_views_;
+	vk::Sampler hiz_sampler_;
+	uint32_t hiz_levels_ = 0;
+
+	vk::DescriptorSetLayout hiz_set_layout_;
+	vk::DescriptorPool hiz_descriptor_pool_;
+	std::vector<vk::DescriptorSet> hiz_descriptor_sets_;
+	vk::PipelineLayout hiz_pipeline_layout_;
+	vk::Pipeline hiz_pipeline_;
+
+	// dynamic resolution: the scene target the render pass draws into, and the
+	// upscale of it that is all the swapchain images get
+	vk::Image scene_image_;
+	vk::DeviceMemory scene_image_memory_;
+	vk::ImageView scene_image_view_;
+	vk::Framebuffer scene_framebuffer_;
+
+	vk::RenderPass upscale_render_pass_;
+	vk::Sampler upscale_sampler_;
+	vk::DescriptorSetLayout upscale_set_layout_;
+	vk::DescriptorSet upscale_descriptor_set_;
+	vk::PipelineLayout upscale_pipeline_layout_;
+	vk::Pipeline upscale_pipeline_;
+
+	// far field cards and the texture baked for them at startup
+	vk::RenderPass card_render_pass_;
+	vk::Pipeline card_bake_pipeline_;
+
+	vk::Image card_image_;
+	vk::DeviceMemory card_image_memory_;
+	vk::ImageView card_image_view_;
+	vk::Sampler card_sampler_;
+
+	vk::Buffer card_buffer_;
+	vk::DeviceMemory card_buffer_memory_;
+
+	vk::DescriptorSetLayout card_set_layout_;
+	vk::DescriptorSet card_descriptor_set_;
+	vk::PipelineLayout card_pipeline_layout_;
+	vk::Pipeline card_pipeline_;
+
+	job_system& jobs_;
+
+	struct loaded_shader {
+		job_system::handle loaded; // only set when read from a file
+		std::vector<uint32_t> override_code; // the file's contents
+		std::span<const uint32_t> code; // into override_code or the embedded table
+	};
+
+	std::unordered_map<std::string, loaded_shader> shaders_; // by file name, see load_shaders
+
+	vk::PipelineCache pipeline_cache_;
+
+	// shader hot reload, see update_shader_reload
+	struct reloaded_pipeline {
+		vk::Pipeline* slot;
+		vk::Pipeline pipeline;
+	};
+
+	// every frame's graphics submission waits for its compute one, so once the graphics
+	// timeline reaches the value last submitted when it was replaced, nothing uses it anymore
+	struct retired_pipeline {
+		vk::Pipeline pipeline;
+		uint64_t last_use;
+	};
+
+	std::optional<shader_watcher> shader_watcher_;
+	job_system::handle reload_;
+	std::vector<reloaded_pipeline> reloaded_pipelines_; // filled by the reload task only
+	std::unordered_map<std::string, std::vector<uint32_t>> reload_code_; // the same, into shaders_ by finish_reload
+	std::chrono::steady_clock::duration reload_duration_{};
+	std::vector<retired_pipeline> retired_pipelines_;
+
+	struct retired_swapchain {
+		vk::SwapchainKHR swapchain;
+		uint64_t last_use; // the graphics timeline value it is kept until
+	};
+
+	std::vector<retired_swapchain> retired_swapchains_;
+
+	// set on the thread running a reload, see set_pipeline
+	static inline thread_local std::vector<reloaded_pipeline>* reload_batch_ = nullptr;
+
+	struct {
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<unsigned char> pixels; // rgba8, released once uploaded
+	} decoded_texture_;
+
+	vk::CommandBuffer upload_batch_;
+	std::vector<std::function<void()>> after_upload_;
+
+	struct startup_step {
+		const char* name;
+		uint32_t thread;
+		std::chrono::steady_clock::time_point begin;
+		std::chrono::steady_clock::time_point end;
+	};
+
+	std::mutex startup_mutex_;
+	std::vector<startup_step> startup_steps_;
+
 	uint32_t blades_num_ = 0;
+	uint32_t blades_per_shard_ = 0;
+	uint32_t shard_count_ = 0;
+	uint32_t bucket_capacity_ = 0; // blades per lod range of the culled and sorted buffers
+	uint32_t cards_num_ = 0;
 };
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+#include "config.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// the share of the swapchain extent the scene is rendered at, from the GPU time of the
+// scene pass. the pass is taken to cost in proportion to its pixels, so the scale moves
+// by the square root of budget over time. it drops quicker than it rises, and holds
+// while the time is within a band around the budget, so it does not hunt
+class resolution_controller {
+public:
+	resolution_controller(float budget_ms, float min_scale, float max_scale = 1.0f)
+		: budget_ms_(budget_ms), min_scale_(min_scale), max_scale_(max_scale), scale_(max_scale)
+	{}
+
+public:
+	float scale() const {
+		return scale_;
+	}
+
+	float min_scale() const {
+		return min_scale_;
+	}
+
+	// once per finished frame, with the scale it was rendered at. the frames in
+	// flight were recorded before the last samples came in, so that may lag scale()
+	void add_sample(double scene_ms, float rendered_scale) {
+		if (scene_ms <= 0.0) return;
+
+		const double ratio = budget_ms_ / scene_ms;
+		if (std::abs(ratio - 1.0) < hold_band) return;
+
+		const double target = rendered_scale * std::sqrt(ratio);
+		const double rate = target < scale_ ? drop_rate : rise_rate;
+
+		scale_ = std::clamp(static_cast<float>(scale_ + (target - scale_) * rate), min_scale_, max_scale_);
+	}
+
+	void reset() {
+		scale_ = max_scale_;
+	}
+
+private:
+	static constexpr double hold_band = 0.1;
+	static constexpr double drop_rate = 0.5;
+	static constexpr double rise_rate = 0.1;
+
+	float budget_ms_;
+	float min_scale_;
+	float max_scale_;
+	float scale_;
+};
+
+// at least a pixel each way
+inline vk::Extent2D scaled_extent(vk::Extent2D full, float scale) {
+	return {
+		std::max(static_cast<uint32_t>(full.width * scale), 1u),
+		std::max(static_cast<uint32_t>(full.height * scale), 1u)
+	};
+}
@@ -0,0 +1,73 @@
+# writes the compiled shaders as constexpr uint32_t arrays, see embedded_shaders.hpp
+#
+#	python embed_spirv.py <output header> <spv files...>
+
+import os
+import re
+import struct
+import sys
+
+SPIRV_MAGIC = 0x07230203
+WORDS_PER_LINE = 8
+
+
+def array_name(path):
+	return re.sub(r"\W", "_", os.path.basename(path))
+
+
+def read_words(path):
+	with open(path, "rb") as file:
+		data = file.read()
+
+	if len(data) % 4 != 0:
+		sys.exit(f"{path}: size is not a multiple of 4")
+
+	words = struct.unpack(f"<{len(data) // 4}I", data)
+
+	if not words or words[0] != SPIRV_MAGIC:
+		sys.exit(f"{path}: not little-endian SPIR-V")
+
+	return words
+
+
+def main():
+	if len(sys.argv) < 3:
+		sys.exit("usage: embed_spirv.py <output header> <spv files...>")
+
+	output, inputs = sys.argv[1], sys.argv[2:]
+
+	lines = [
+		"// generated by embed_spirv.py, do not edit",
+		"#pragma once",
+		"",
+	]
+
+	for path in inputs:
+		words = read_words(path)
+
+		lines.append(f"alignas(16) inline constexpr uint32_t {array_name(path)}[] = {{")
+		for i in range(0, len(words), WORDS_PER_LINE):
+			lines.append("\t" + ", ".join(f"0x{word:08x}" for word in words[i:i + WORDS_PER_LINE]) + ",")
+		lines.append("};")
+		lines.append("")
+
+	lines.append("inline constexpr embedded_shader embedded_shader_table[] = {")
+	for path in inputs:
+		lines.append(f"\t{{ \"{os.path.basename(path)}\", {array_name(path)} }},")
+	lines.append("};")
+	lines.append("")
+
+	# untouched if nothing changed, so the application is not rebuilt for nothing
+	text = "\n".join(lines)
+
+	if os.path.exists(output):
+		with open(output) as file:
+			if file.read() == text:
+				return
+
+	with open(output, "w") as file:
+		file.write(text)
+
+
+if __name__ == "__main__":
+	main()
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+// SPIR-V compiled into the executable, so shaders need neither file I/O nor
+// a particular working directory. the table comes from embed_spirv.py, which
+// compile_shaders.py runs on every shader it compiles:
+//
+//	python compile_shaders.py
+//
+// run before compiling the application. without the generated header the
+// table is empty and every shader is read from disk
+struct embedded_shader {
+	std::string_view file;
+	std::span<const uint32_t> code;
+};
+
+#if __has_include("shaders_spirv.hpp")
+#include "shaders_spirv.hpp"
+#else
+inline constexpr std::span<const embedded_shader> embedded_shader_table{};
+#endif
+
+// empty if the file was not embedded
+inline std::span<const uint32_t> find_embedded_shader(std::string_view file) {
+	for (const auto& shader : std::span<const embedded_shader>(embedded_shader_table))
+		if (shader.file == file) return shader.code;
+
+	return {};
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include "config.hpp"
+
+#include <vector>
+#include <array>
+#include <string_view>
+#include <optional>
+#include <thread>
+#include <algorithm>
+
+// how frames reach the screen. the swapchain takes the present mode from here,
+// the frame limiter only runs with vsync
+enum class present_policy {
+	low_latency,	// mailbox, the newest frame replaces a queued one, no tearing
+	vsync,			// fifo, with the CPU held to the refresh rate so no frames queue up
+	relaxed,		// fifo relaxed, tears instead of waiting a whole refresh when late
+	uncapped		// immediate, tears, only for measuring
+};
+
+inline const char* present_policy_name(present_policy policy) {
+	switch (policy) {
+	case present_policy::low_latency: return "low latency";
+	case present_policy::vsync: return "vsync";
+	case present_policy::relaxed: return "relaxed";
+	case present_policy::uncapped: return "uncapped";
+	}
+
+	return "";
+}
+
+// GRASS_PRESENT=mailbox|fifo|relaxed|immediate
+inline std::optional<present_policy> parse_present_policy(std::string_view name) {
+	if (name == "mailbox") return present_policy::low_latency;
+	if (name == "fifo") return present_policy::vsync;
+	if (name == "relaxed") return present_policy::relaxed;
+	if (name == "immediate") return present_policy::uncapped;
+
+	return std::nullopt;
+}
+
+// holds the render loop to one frame per interval. it waits before the input is
+// read, so the frame is as fresh as possible once it is shown. sleeps most of the
+// way and spins the rest, sleep alone overshoots by up to a scheduler tick
+class frame_limiter {
+public:
+	using clock = std::chrono::steady_clock;
+
+	void set_interval(clock::duration interval) {
+		interval_ = interval;
+	}
+
+	clock::duration interval() const {
+		return interval_;
+	}
+
+	void wait() {
+		if (interval_ == clock::duration::zero()) return;
+
+		const auto now = clock::now();
+
+		// fell behind by more than a frame, start over instead of rushing to catch up
+		if (next_ + interval_ < now) next_ = now;
+
+		if (next_ - now > spin_time) std::this_thread::sleep_until(next_ - spin_time);
+		while (clock::now() < next_) std::this_thread::yield();
+
+		next_ += interval_;
+	}
+
+private:
+	static constexpr auto spin_time = std::chrono::milliseconds(1);
+
+	clock::duration interval_ = clock::duration::zero();
+	clock::time_point next_ = clock::now();
+};
+
+// the time from reading the input to the frame showing it on screen. with
+// VK_GOOGLE_display_timing the end is the actual present time, otherwise it is
+// estimated as the moment the frame's fence is seen signaled plus the refresh
+// interval the presentation engine may still hold it for
+class latency_tracker {
+public:
+	using clock = std::chrono::steady_clock;
+
+	void add(clock::duration latency) {
+		const double milliseconds = std::chrono::duration<double, std::milli>(latency).count();
+
+		samples_[next_++ % samples_.size()] = milliseconds;
+		count_ = std::min<size_t>(count_ + 1, samples_.size());
+	}
+
+	// over the last samples_.size() frames
+	double average_ms() const {
+		if (count_ == 0) return 0.0;
+
+		double sum = 0.0;
+		for (size_t i = 0; i < count_; ++i)
+			sum += samples_[i];
+
+		return sum / count_;
+	}
+
+	double max_ms() const {
+		return count_ ? *std::max_element(samples_.begin(), samples_.begin() + count_) : 0.0;
+	}
+
+	size_t count() const {
+		return count_;
+	}
+
+private:
+	std::array<double, 240> samples_{};
+	size_t next_ = 0;
+	size_t count_ = 0;
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include "config.hpp"
+#include "blade.hpp"
+
+#include <algorithm>
+
+// what the compute pass of a frame counted, copied as it is into a readback slot
+// at the end of the compute command buffer, see device_context::create_stats_readback
+struct frame_stats_block {
+	blade_draw_commands draws;
+	blade_awake_list awake; // the header only, not the indices
+	blade_cull_stats cull;
+};
+
+// the counts of a finished frame. they arrive MAX_FRAMES_IN_FLIGHT frames late,
+// once the frame slot comes round again and its work is known to be done
+struct frame_stats {
+	uint64_t frame = 0; // the compute timeline value of the frame, 0 until the first one is in
+
+	uint32_t visible_blades[lod_count]{};
+	uint32_t visible_total = 0;
+
+	uint32_t awake_blades = 0;
+	uint32_t asleep_blades = 0;
+
+	blade_cull_stats cull{};
+
+public:
+	// the buckets of strip lods count instances, the others vertices. a bucket
+	// counts past its capacity, the blades that did not fit were not drawn
+	static frame_stats from_block(const frame_stats_block& block, uint64_t frame, uint32_t strip_lods, uint32_t bucket_capacity) {
+		frame_stats stats{};
+		stats.frame = frame;
+
+		for (uint32_t lod = 0; lod < lod_count; ++lod) {
+			const auto& draw = block.draws.lods[lod];
+			const uint32_t count = strip_lods & (1u << lod) ? draw.instance_count : draw.vertex_count;
+
+			stats.visible_blades[lod] = std::min(count, bucket_capacity);
+			stats.visible_total += stats.visible_blades[lod];
+		}
+
+		stats.awake_blades = block.awake.awake_count;
+		stats.asleep_blades = block.awake.asleep_count;
+		stats.cull = block.cull;
+
+		return stats;
+	}
+};
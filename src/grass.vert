@@ -1,5 +1,6 @@
 #version 450
 
+// v1 and v2 come relative to v0, in half precision, see blade in blade.hpp
 layout(location = 0) in vec4 in_v0;
 layout(location = 1) in vec4 in_v1;
 layout(location = 2) in vec4 in_v2;
@@ -17,8 +18,8 @@ layout(push_constant) uniform push_data {
 void main() {
 
 	out_v0 = vec4((push.model_matrix * vec4(in_v0.xyz, 1.0f)).xyz, in_v0.w);
-	out_v1 = vec4((push.model_matrix * vec4(in_v1.xyz, 1.0f)).xyz, in_v1.w);
-	out_v2 = vec4((push.model_matrix * vec4(in_v2.xyz, 1.0f)).xyz, in_v2.w);
+	out_v1 = vec4((push.model_matrix * vec4(in_v0.xyz + in_v1.xyz, 1.0f)).xyz, in_v1.w);
+	out_v2 = vec4((push.model_matrix * vec4(in_v0.xyz + in_v2.xyz, 1.0f)).xyz, in_v2.w);
 	out_up = vec4(normalize(out_v1 - out_v0).xyz, 0.0f); //in_up.w is stiffness
 
 	gl_Position = vec4(out_v0.xyz, 1.0f);
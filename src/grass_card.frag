@@ -0,0 +1,22 @@
+#version 450
+
+layout(location = 0) out vec4 frag_color;
+
+layout(location = 0) in vec2 uv;
+layout(location = 1) in float fade;
+
+// blades rendered with grass.frag at startup, alpha is their coverage
+layout(set = 0, binding = 0) uniform sampler2D card;
+
+// screen-door transparency, blends with the blades without sorting the cards
+float dither(vec2 p) {
+	return fract(52.9829189 * fract(dot(p, vec2(0.06711056, 0.00583715))));
+}
+
+void main() {
+	vec4 texel = texture(card, uv);
+
+	if (texel.a < 0.5 || fade <= dither(gl_FragCoord.xy)) discard;
+
+	frag_color = vec4(texel.rgb, 1.0);
+}
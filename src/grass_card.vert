@@ -0,0 +1,41 @@
+#version 450
+
+// a far field card: a vertical quad per instance, fading in
+// over the band where grass.comp fades the blades out
+
+layout(constant_id = 0) const float card_fade_start = 25.0;
+layout(constant_id = 1) const float card_fade_end = 35.0;
+
+// per instance
+layout(location = 0) in vec4 in_position; // w is the rotation around the up axis
+layout(location = 1) in vec4 in_size;
+
+layout(location = 0) out vec2 uv;
+layout(location = 1) out float fade;
+
+layout(push_constant) uniform push_data {
+	mat4 view_matrix;
+	mat4 projection_matrix;
+	vec4 eye;
+} push;
+
+void main() {
+	// a strip of 4 vertices, bottom left first
+	float u = float(gl_VertexIndex & 1);
+	float v = float(gl_VertexIndex >> 1);
+
+	// the same distance grass.comp measures, projected on the ground
+	vec3 up = vec3(0.0, 1.0, 0.0);
+	vec3 to_card = in_position.xyz - push.eye.xyz;
+	float dproj = length(to_card - up * dot(to_card, up));
+
+	fade = clamp((dproj - card_fade_start) / (card_fade_end - card_fade_start), 0.0, 1.0);
+
+	vec3 side = vec3(cos(in_position.w), 0.0, sin(in_position.w));
+	vec3 p = in_position.xyz + (u - 0.5) * in_size.x * side + v * in_size.y * up;
+
+	// nothing to draw before the band, the quad collapses
+	gl_Position = fade > 0.0 ? push.projection_matrix * push.view_matrix * vec4(p, 1.0) : vec4(0.0);
+
+	uv = vec2(u, 1.0 - v);
+}
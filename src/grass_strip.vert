@@ -0,0 +1,55 @@
+#version 450
+
+// a blade without tessellation: one instance per blade, expanded into a
+// triangle strip of 2 * (segments + 1) vertices along the same curve
+// grass.tese evaluates, so both paths produce the same shape
+
+layout(constant_id = 0) const uint segments = 2;
+
+// per instance, v1 and v2 relative to v0 as blade in blade.hpp keeps them
+layout(location = 0) in vec4 in_v0;
+layout(location = 1) in vec4 in_v1;
+layout(location = 2) in vec4 in_v2;
+layout(location = 3) in vec4 in_up;
+
+layout(location = 0) out vec4 position;
+layout(location = 1) out vec4 normal;
+
+layout(push_constant) uniform push_data {
+	mat4 model_matrix;
+	mat4 view_matrix;
+	mat4 projection_matrix;
+} push;
+
+void main() {
+	// even vertices run along the left edge, odd ones along the right one
+	float u = float(gl_VertexIndex & 1);
+	float v = float(gl_VertexIndex >> 1) / float(segments);
+
+	vec3 v0 = (push.model_matrix * vec4(in_v0.xyz, 1.0f)).xyz;
+	vec3 v1 = (push.model_matrix * vec4(in_v0.xyz + in_v1.xyz, 1.0f)).xyz;
+	vec3 v2 = (push.model_matrix * vec4(in_v0.xyz + in_v2.xyz, 1.0f)).xyz;
+
+	float width = in_v2.w;
+	float direction_angle = in_v0.w;
+
+	vec3 t1 = vec3(-cos(direction_angle), 0.0, sin(direction_angle));
+
+	vec3 a = v0 + v * (v1 - v0); // amount up
+	vec3 b = v1 + v * (v2 - v1); // amount forward
+	vec3 c = a + v * (b - a);
+
+	vec3 c0 = c - width * t1;
+	vec3 c1 = c + width * t1;
+
+	float t = u + 0.5f * v - u * v;
+
+	vec3 p = (1 - t) * c0 + t * c1;
+
+	gl_Position = push.projection_matrix * push.view_matrix * vec4(p, 1.0f);
+
+	vec3 t0 = normalize(b - a);
+	normal = vec4(normalize(cross(t0, t1)), 0.0);
+
+	position = vec4(v0, in_v0.w);
+}
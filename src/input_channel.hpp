@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+
+// one thread publishes, another reads whatever was published last. three slots: the
+// producer writes its own, the consumer reads its own, and the third is swapped
+// between them with a flag for whether it holds something newer. neither side waits,
+// values the consumer did not get to in time are simply skipped
+template<typename T>
+class snapshot_channel {
+public:
+	// producer only
+	void publish(const T& value) {
+		slots_[back_] = value;
+		back_ = middle_.exchange(back_ | fresh, std::memory_order_acq_rel) & index_mask;
+	}
+
+	// consumer only: the newest value, the one from the previous call if nothing was published since
+	const T& latest() {
+		if (middle_.load(std::memory_order_relaxed) & fresh)
+			front_ = middle_.exchange(front_, std::memory_order_acq_rel) & index_mask;
+
+		return slots_[front_];
+	}
+
+private:
+	static constexpr uint8_t index_mask = 0x3;
+	static constexpr uint8_t fresh = 0x4;
+
+	std::array<T, 3> slots_{};
+	uint8_t back_ = 0; // producer's
+	uint8_t front_ = 1; // consumer's
+	std::atomic<uint8_t> middle_{ 2 };
+};
+
+// a bounded ring for events that must not be skipped, one producer and one consumer.
+// push fails once the consumer is capacity items behind
+template<typename T, size_t capacity>
+class spsc_queue {
+public:
+	// producer only
+	bool push(const T& item) {
+		const size_t tail = tail_.load(std::memory_order_relaxed);
+		if (tail - head_.load(std::memory_order_acquire) == capacity) return false;
+
+		items_[tail % capacity] = item;
+		tail_.store(tail + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	// consumer only
+	std::optional<T> pop() {
+		const size_t head = head_.load(std::memory_order_relaxed);
+		if (head == tail_.load(std::memory_order_acquire)) return std::nullopt;
+
+		T item = items_[head % capacity];
+		head_.store(head + 1, std::memory_order_release);
+
+		return item;
+	}
+
+private:
+	std::array<T, capacity> items_{};
+
+	// apart, so the two threads do not share a cache line
+	alignas(64) std::atomic<size_t> head_{ 0 };
+	alignas(64) std::atomic<size_t> tail_{ 0 };
+};
@@ -0,0 +1,362 @@
+#pragma once
+#include "config.hpp"
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <exception>
+#include <stdexcept>
+#include <fstream>
+
+// a pool of worker threads with a task queue each. a task spawned on a worker goes
+// to the back of that worker's queue and is taken from there, idle threads steal
+// from the front of the others. a task starts once all its dependencies are done,
+// wait() runs other tasks meanwhile instead of blocking. besides the workers, the thread
+// that created the pool and every thread registered with register_thread may run tasks:
+// each has a queue and an index of its own.
+// background tasks, see submit_background, share one more queue. only the workers take
+// from it, and a thread that waits runs them only if it is inside one itself
+class job_system {
+public:
+	using clock = std::chrono::steady_clock;
+
+	class task {
+	public:
+		bool done() const {
+			return done_.load(std::memory_order_acquire);
+		}
+
+	private:
+		friend class job_system;
+
+		const char* name_ = "";
+		std::function<void()> work_;
+		bool background_ = false;
+		std::atomic<uint32_t> unfinished_dependencies_ = 0;
+		std::atomic<bool> done_ = false;
+		std::exception_ptr error_;
+
+		std::mutex mutex_;
+		std::vector<std::shared_ptr<task>> dependents_;
+	};
+
+	using handle = std::shared_ptr<task>;
+
+	// the profiling hook gets one of these per task run
+	struct task_span {
+		const char* name;
+		uint32_t thread;
+		clock::time_point begin;
+		clock::time_point end;
+	};
+
+	using profiler = std::function<void(const task_span&)>;
+
+	// external_threads counts the creating thread and the ones registered later
+	explicit job_system(uint32_t workers, uint32_t external_threads = 1)
+		: queues_(workers + external_threads), next_external_(workers + 1)
+	{
+		thread_index_ = workers;
+
+		for (uint32_t i = 0; i < workers; ++i)
+			workers_.emplace_back([this, i] { work(i); });
+	}
+
+	~job_system() {
+		{
+			std::lock_guard lock(sleep_mutex_);
+			stopping_ = true;
+		}
+
+		wake_.notify_all();
+
+		for (auto& worker : workers_)
+			worker.join();
+	}
+
+	job_system(const job_system&) = delete;
+	job_system& operator=(const job_system&) = delete;
+
+public:
+	// name is kept as is for the profiler, a string literal. a task submitted from inside
+	// a background task is a background task too
+	handle submit(const char* name, std::function<void()> work, const std::vector<handle>& dependencies = {}) {
+		return create(name, std::move(work), dependencies, in_background_);
+	}
+
+	// for long work that nothing waits on every frame, shader compiles and pipeline builds.
+	// a frame's wait() never picks it up in between, so it cannot stall the frame
+	handle submit_background(const char* name, std::function<void()> work, const std::vector<handle>& dependencies = {}) {
+		return create(name, std::move(work), dependencies, true);
+	}
+
+	// runs other tasks until this one is done, then rethrows whatever it threw
+	void wait(const handle& awaited) {
+		const bool background = in_background_;
+
+		while (!awaited->done()) {
+			if (run_one(background)) continue;
+
+			std::unique_lock lock(sleep_mutex_);
+			++sleepers_;
+			wake_.wait(lock, [&] { return awaited->done() || queued_ > 0 || (background && background_queued_ > 0); });
+			--sleepers_;
+		}
+
+		if (awaited->error_) std::rethrow_exception(awaited->error_);
+	}
+
+	void wait(const std::vector<handle>& awaited) {
+		for (const auto& one : awaited)
+			wait(one);
+	}
+
+	// body(first, last) over [0, count) in chunks of grain, returns once all are done
+	void parallel_for(const char* name, uint32_t count, uint32_t grain, const std::function<void(uint32_t, uint32_t)>& body) {
+		std::vector<handle> chunks;
+
+		for (uint32_t first = 0; first < count; first += grain) {
+			const uint32_t last = std::min(first + grain, count);
+			chunks.push_back(submit(name, [&body, first, last] { body(first, last); }));
+		}
+
+		wait(chunks);
+	}
+
+	// called on the thread that ran the task, right after it. set it while nothing runs
+	void set_profiler(profiler hook) {
+		profiler_ = std::move(hook);
+	}
+
+	// the workers, the thread that created the pool and the ones it was sized to register
+	uint32_t threads() const {
+		return static_cast<uint32_t>(queues_.size());
+	}
+
+	// in [0, threads()). the workers come first, then the creating thread, then the registered
+	// ones in the order they registered. a thread that is neither reads 0, a worker's index
+	static uint32_t thread_index() {
+		return thread_index_;
+	}
+
+	// on a thread other than the workers and the creating one, before it submits or waits on
+	// anything. it gets an index of its own, so whatever is kept per index is not shared
+	void register_thread() {
+		const uint32_t index = next_external_++;
+		if (index >= queues_.size()) throw std::runtime_error("the job system has no index left for another thread!");
+
+		thread_index_ = index;
+	}
+
+private:
+	struct task_queue {
+		std::mutex mutex;
+		std::deque<handle> tasks;
+	};
+
+	handle create(const char* name, std::function<void()> work, const std::vector<handle>& dependencies, bool background) {
+		auto new_task = std::make_shared<task>();
+		new_task->name_ = name;
+		new_task->work_ = std::move(work);
+		new_task->background_ = background;
+
+		// held until every dependency is registered, so none of them can start it early
+		new_task->unfinished_dependencies_ = static_cast<uint32_t>(dependencies.size()) + 1;
+
+		for (const auto& dependency : dependencies) {
+			std::lock_guard lock(dependency->mutex_);
+
+			if (dependency->done()) --new_task->unfinished_dependencies_;
+			else dependency->dependents_.push_back(new_task);
+		}
+
+		if (--new_task->unfinished_dependencies_ == 0) schedule(new_task);
+
+		return new_task;
+	}
+
+	void schedule(handle ready) {
+		const bool background = ready->background_;
+		auto& queue = background ? background_queue_ : queues_[thread_index_];
+
+		{
+			std::lock_guard lock(queue.mutex);
+			queue.tasks.push_back(std::move(ready));
+		}
+
+		{
+			std::lock_guard lock(sleep_mutex_);
+			++(background ? background_queued_ : queued_);
+		}
+
+		// the one woken up might be a thread that does not take background tasks
+		if (background) wake_.notify_all();
+		else wake_.notify_one();
+	}
+
+	// the newest task of this thread, or the oldest of another one,
+	// or else the oldest background task if background is set
+	handle take(bool background) {
+		const uint32_t self = thread_index_;
+
+		for (uint32_t i = 0; i < queues_.size(); ++i) {
+			const uint32_t victim = (self + i) % queues_.size();
+			auto& queue = queues_[victim];
+
+			std::lock_guard lock(queue.mutex);
+			if (queue.tasks.empty()) continue;
+
+			handle taken;
+			if (victim == self) {
+				taken = std::move(queue.tasks.back());
+				queue.tasks.pop_back();
+			}
+			else {
+				taken = std::move(queue.tasks.front());
+				queue.tasks.pop_front();
+			}
+
+			--queued_;
+			return taken;
+		}
+
+		if (!background) return nullptr;
+
+		std::lock_guard lock(background_queue_.mutex);
+		if (background_queue_.tasks.empty()) return nullptr;
+
+		auto taken = std::move(background_queue_.tasks.front());
+		background_queue_.tasks.pop_front();
+
+		--background_queued_;
+		return taken;
+	}
+
+	bool run_one(bool background) {
+		auto next = take(background);
+		if (!next) return false;
+
+		run(next);
+		return true;
+	}
+
+	void run(const handle& current) {
+		const auto begin = clock::now();
+
+		// a task run inside a background task's wait() returns to it after
+		const bool outer_background = in_background_;
+		in_background_ = current->background_;
+
+		try {
+			current->work_();
+		}
+		catch (...) {
+			current->error_ = std::current_exception();
+		}
+
+		in_background_ = outer_background;
+
+		current->work_ = nullptr;
+
+		if (profiler_) profiler_({ current->name_, thread_index_, begin, clock::now() });
+
+		std::vector<handle> dependents;
+
+		{
+			std::lock_guard lock(current->mutex_);
+			current->done_.store(true, std::memory_order_release);
+			dependents.swap(current->dependents_);
+		}
+
+		for (auto& dependent : dependents)
+			if (--dependent->unfinished_dependencies_ == 0) schedule(std::move(dependent));
+
+		// someone may be waiting on exactly this task
+		bool sleepers;
+		{
+			std::lock_guard lock(sleep_mutex_);
+			sleepers = sleepers_ > 0;
+		}
+
+		if (sleepers) wake_.notify_all();
+	}
+
+	void work(uint32_t index) {
+		thread_index_ = index;
+
+		for (;;) {
+			if (run_one(true)) continue;
+
+			std::unique_lock lock(sleep_mutex_);
+			++sleepers_;
+			wake_.wait(lock, [this] { return stopping_ || queued_ > 0 || background_queued_ > 0; });
+			--sleepers_;
+
+			if (stopping_) return;
+		}
+	}
+
+private:
+	std::vector<task_queue> queues_; // a thread's own at its index, see thread_index
+	task_queue background_queue_;
+	std::atomic<uint32_t> next_external_;
+	std::vector<std::thread> workers_;
+
+	std::mutex sleep_mutex_;
+	std::condition_variable wake_;
+	std::atomic<uint32_t> queued_ = 0;
+	std::atomic<uint32_t> background_queued_ = 0;
+	uint32_t sleepers_ = 0;
+	bool stopping_ = false;
+
+	profiler profiler_;
+
+	static inline thread_local uint32_t thread_index_ = 0;
+	static inline thread_local bool in_background_ = false; // running a background task
+};
+
+// collects the spans of the job system's profiling hook and writes them out
+// in the chrome://tracing format, a row per thread
+class job_trace {
+public:
+	job_system::profiler hook() {
+		return [this](const job_system::task_span& span) {
+			std::lock_guard lock(mutex_);
+			spans_.push_back(span);
+		};
+	}
+
+	void write_json(const std::string& path) const {
+		std::ofstream file(path);
+		if (!file.is_open())
+			throw std::runtime_error("failed to open " + path + "!");
+
+		std::lock_guard lock(mutex_);
+
+		const auto microseconds = [&](job_system::clock::time_point time) {
+			return std::chrono::duration<double, std::micro>(time - start_).count();
+		};
+
+		file << "{\"traceEvents\":[\n";
+
+		for (size_t i = 0; i < spans_.size(); ++i) {
+			const auto& span = spans_[i];
+
+			file << "{\"name\":\"" << span.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << span.thread
+				<< ",\"ts\":" << microseconds(span.begin) << ",\"dur\":" << microseconds(span.end) - microseconds(span.begin) << "}"
+				<< (i + 1 < spans_.size() ? ",\n" : "\n");
+		}
+
+		file << "]}\n";
+	}
+
+private:
+	job_system::clock::time_point start_ = job_system::clock::now();
+
+	mutable std::mutex mutex_;
+	std::vector<job_system::task_span> spans_;
+};
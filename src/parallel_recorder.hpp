@@ -0,0 +1,108 @@
+#pragma once
+#include "config.hpp"
+#include "job_system.hpp"
+
+#include <vector>
+#include <functional>
+
+// records the draws of a render pass into secondary command buffers on the job
+// system's threads, the primary buffer only executes them. every thread, the calling
+// one included, has a command pool per frame in flight: the pool is reset as a whole
+// once the frame's fence has been waited on and its buffers are reused
+class parallel_recorder {
+public:
+	using job = std::function<void(vk::CommandBuffer)>;
+
+	parallel_recorder(vk::Device device, uint32_t queue_family, uint32_t frames, job_system& jobs)
+		: device_(device), jobs_(jobs), pools_(frames)
+	{
+		vk::CommandPoolCreateInfo pool_info{};
+		pool_info.flags = vk::CommandPoolCreateFlagBits::eTransient;
+		pool_info.queueFamilyIndex = queue_family;
+
+		for (auto& frame_pools : pools_) {
+			frame_pools.resize(jobs_.threads());
+
+			for (auto& pool : frame_pools)
+				pool.pool = device_.createCommandPool(pool_info);
+		}
+	}
+
+	~parallel_recorder() {
+		// the last frames may still be executing
+		device_.waitIdle();
+
+		for (auto& frame_pools : pools_)
+			for (auto& pool : frame_pools)
+				device_.destroyCommandPool(pool.pool);
+	}
+
+	parallel_recorder(const parallel_recorder&) = delete;
+	parallel_recorder& operator=(const parallel_recorder&) = delete;
+
+public:
+	// the frame's previous submission has completed, its buffers can be recorded anew
+	void begin_frame(uint32_t frame) {
+		frame_ = frame;
+
+		for (auto& pool : pools_[frame_]) {
+			device_.resetCommandPool(pool.pool);
+			pool.used = 0;
+		}
+	}
+
+	// a secondary buffer per job, in job order, each continuing the render pass of inheritance.
+	// the jobs run concurrently and must only read shared state. returns once all are recorded
+	std::vector<vk::CommandBuffer> record(const vk::CommandBufferInheritanceInfo& inheritance, const std::vector<job>& jobs) {
+		std::vector<vk::CommandBuffer> results(jobs.size());
+		std::vector<job_system::handle> tasks;
+
+		for (size_t index = 0; index < jobs.size(); ++index) {
+			tasks.push_back(jobs_.submit("record draws", [&, index] {
+				// a pool is only ever used by the thread it belongs to
+				auto command_buffer = next_buffer(pools_[frame_][job_system::thread_index()]);
+
+				vk::CommandBufferBeginInfo begin_info{};
+				begin_info.flags = vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+				begin_info.pInheritanceInfo = &inheritance;
+
+				command_buffer.begin(begin_info);
+				jobs[index](command_buffer);
+				command_buffer.end();
+
+				results[index] = command_buffer;
+			}));
+		}
+
+		// the calling thread records as well rather than waiting idle
+		jobs_.wait(tasks);
+
+		return results;
+	}
+
+private:
+	struct thread_pool {
+		vk::CommandPool pool;
+		std::vector<vk::CommandBuffer> buffers; // grows to the most jobs a thread has taken in a frame
+		uint32_t used = 0;
+	};
+
+	vk::CommandBuffer next_buffer(thread_pool& pool) {
+		if (pool.used == pool.buffers.size()) {
+			vk::CommandBufferAllocateInfo alloc_info{};
+			alloc_info.commandPool = pool.pool;
+			alloc_info.level = vk::CommandBufferLevel::eSecondary;
+			alloc_info.commandBufferCount = 1;
+
+			pool.buffers.push_back(device_.allocateCommandBuffers(alloc_info).front());
+		}
+
+		return pool.buffers[pool.used++];
+	}
+
+private:
+	vk::Device device_;
+	job_system& jobs_;
+	std::vector<std::vector<thread_pool>> pools_; // frame, then job_system::thread_index()
+	uint32_t frame_ = 0;
+};
@@ -8,5 +8,5 @@ layout(location = 0) out vec4 outColor;
 layout(binding = 1) uniform sampler2D texSampler;
 
 void main() {
-	outColor = texture(texSampler, fragTexCoord * 2.0f);
+	outColor = texture(texSampler, fragTexCoord * 2.0f) * vec4(fragColor, 1.0f); // fragColor is the terrain shading
 }
\ No newline at end of file
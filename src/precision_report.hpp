@@ -0,0 +1,84 @@
+#pragma once
+#include "config.hpp"
+#include "blade.hpp"
+#include "tools.hpp"
+
+#include <vector>
+#include <span>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+// how far the fp16 physics drifts from the fp32 one, see GRASS_FP16_REPORT.
+// both pools were simulated side by side from the same blades, the distances
+// between their control points are in world units. both run on the live pool's
+// awake list, a blade counts as asleep once its own rest_frames would put it to sleep
+class precision_report {
+public:
+	struct error {
+		double max = 0.0;
+		double sum = 0.0;
+		double sum_squared = 0.0;
+		uint64_t count = 0;
+
+		void add(double distance) {
+			max = std::max(max, distance);
+			sum += distance;
+			sum_squared += distance * distance;
+			++count;
+		}
+
+		double mean() const {
+			return count ? sum / count : 0.0;
+		}
+
+		double rms() const {
+			return count ? std::sqrt(sum_squared / count) : 0.0;
+		}
+	};
+
+	// only the blades of occupied slots, the others hold nothing either pool simulated
+	precision_report(std::span<const blade> live, std::span<const blade> reference, std::span<const blade_state> live_states, std::span<const blade_state> reference_states, const std::vector<grass_tile_slot>& slots, uint32_t blades_per_tile) {
+		for (uint32_t slot = 0; slot < slots.size(); ++slot) {
+			for (uint32_t i = 0; i < slots[slot].blade_count; ++i) {
+				const uint32_t id = slot * blades_per_tile + i;
+
+				const bool live_asleep = live_states[id].rest_frames >= tools::params::REST_FRAMES_TO_SLEEP;
+				const bool reference_asleep = reference_states[id].rest_frames >= tools::params::REST_FRAMES_TO_SLEEP;
+
+				live_asleep_ += live_asleep;
+				reference_asleep_ += reference_asleep;
+				asleep_mismatches_ += live_asleep != reference_asleep;
+
+				// both relative to the same v0
+				const auto live_v1 = blade::unpack_half4(live[id].v1);
+				const auto live_v2 = blade::unpack_half4(live[id].v2);
+				const auto reference_v1 = blade::unpack_half4(reference[id].v1);
+				const auto reference_v2 = blade::unpack_half4(reference[id].v2);
+
+				v1_.add(glm::distance(glm::vec3(live_v1), glm::vec3(reference_v1)));
+				v2_.add(glm::distance(glm::vec3(live_v2), glm::vec3(reference_v2)));
+
+				// relative to the blade's height, v1.w
+				tip_.add(glm::distance(glm::vec3(live_v2), glm::vec3(reference_v2)) / std::max(reference_v1.w, 1e-6f));
+			}
+		}
+	}
+
+	void print(float simulated_seconds) const {
+		std::cout << "fp16 physics against fp32 after " << simulated_seconds << " simulated seconds, " << v2_.count << " blades:" << std::endl;
+		std::cout << "  v1 error: max " << v1_.max << ", mean " << v1_.mean() << ", rms " << v1_.rms() << std::endl;
+		std::cout << "  v2 error: max " << v2_.max << ", mean " << v2_.mean() << ", rms " << v2_.rms() << std::endl;
+		std::cout << "  v2 error per blade height: max " << tip_.max << ", mean " << tip_.mean() << std::endl;
+		std::cout << "  asleep: fp16 " << live_asleep_ << ", fp32 " << reference_asleep_ << ", " << asleep_mismatches_ << " blades differ" << std::endl;
+	}
+
+private:
+	error v1_;
+	error v2_;
+	error tip_;
+
+	uint64_t live_asleep_ = 0;
+	uint64_t reference_asleep_ = 0;
+	uint64_t asleep_mismatches_ = 0;
+};
@@ -1,17 +1,33 @@
 #pragma once
 #include "device_context.hpp"
-#include "dimensional.hpp"
+#include "terrain.hpp"
+#include "tile_streamer.hpp"
+#include "parallel_recorder.hpp"
 #include "camera.hpp"
+#include "benchmark.hpp"
+#include "precision_report.hpp"
+
+#include "input_channel.hpp"
 
 #include <chrono>
+#include <optional>
+#include <cstdlib>
+#include <thread>
+#include <atomic>
+#include <exception>
 
-camera camera_;
+camera camera_; // main thread only, the render thread gets input_snapshot
 
 struct time_data_t {
 	float delta_time = 0.0f;
 	float total_time = 0.0f;
 };
 
+struct wind_data_t {
+	float power = 10.0f;
+	uint32_t epoch = 0; // sleeping blades wake up as soon as it changes
+};
+
 namespace {
 	bool	leftMouseDown	= false;
 	bool	rightMouseDown	= false;
@@ -60,33 +76,222 @@ namespace {
 	}
 }
 
+// what the render thread knows of the window and the input, published by the main thread
+// whenever it has handled events, see render_system::run
+struct input_snapshot {
+	glm::mat4 view{ 1.0f };
+	glm::vec3 eye{ 0.0f };
+	vk::Extent2D framebuffer; // 0 by 0 while minimized
+};
+
 class render_system {
 public:
+	// GLFW wants its events handled on the main thread, which does nothing else here: it
+	// moves the camera and hands it over, the render thread records, submits and presents.
+	// whatever blocks over there, acquire, present or a fence, never holds up the input
 	void run() {
 		glfwSetMouseButtonCallback(GPU_.window_, mouseDownCallback);
 		glfwSetCursorPosCallback(GPU_.window_, mouseMoveCallback);
 
+		glfwSetWindowUserPointer(GPU_.window_, this);
+
+		// the keys change render state, the render thread handles them, see handle_key
+		glfwSetKeyCallback(GPU_.window_, [](GLFWwindow* window, int key, int scancode, int action, int mods) {
+			auto app = static_cast<render_system*>(glfwGetWindowUserPointer(window));
+			if (action == GLFW_PRESS) app->keys_.push(key);
+		});
+
+		// resizes and minimizes, the swapchain is rebuilt before the next frame
+		glfwSetFramebufferSizeCallback(GPU_.window_, [](GLFWwindow* window, int width, int height) {
+			static_cast<render_system*>(glfwGetWindowUserPointer(window))->framebuffer_ =
+				vk::Extent2D{ static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+		});
+
+		framebuffer_ = GPU_.framebuffer_extent_;
+
+		// task and mesh shaders wherever the device has them
+		path_ = GPU_.mesh_shaders_ ? grass_path::mesh : grass_path::tessellation;
+
 		camera_.set_view_direction(glm::vec3(1.f, 1.f, 1.f), glm::vec3(0.f, 0.f, 0.f), glm::vec3(0.0f, 1.0f, 0.0f));
-		
-		plane.transform.rotation = { -3.1415 / 2.f, -3.1415 / 2.f, 0. };
-		plane.transform.scale = { 30.f, 30.f, 30.f };
+		publish_input();
+
+		if (std::getenv("GRASS_JOB_TRACE")) {
+			job_trace_.emplace();
+			jobs_.set_profiler(job_trace_->hook());
+		}
 
+		// GRASS_SHADER_RELOAD=1 rebuilds the pipelines of a changed shader while running
+		if (std::getenv("GRASS_SHADER_RELOAD")) GPU_.watch_shaders();
+
+		// the first run on a device tunes the workgroup sizes of the grass kernels
+		if (!GPU_.workgroup_sizes_tuned_ && GPU_.compute_timestamp_pool_) start_workgroup_tuning();
+
+		// GRASS_FP16_REPORT=1 compares the fp16 physics to fp32, see update_fp16_report
+		if (std::getenv("GRASS_FP16_REPORT")) {
+			if (GPU_.fp16_physics()) fp16_report_.emplace();
+			else std::cout << "the blade physics runs in fp32, there is no fp16 error to report" << std::endl;
+		}
+
+		// GRASS_BENCHMARK=1 runs the benchmark right away and quits when it is done
+		if (std::getenv("GRASS_BENCHMARK")) {
+			start_benchmark();
+			quit_after_benchmark_ = true;
+		}
+
+		std::thread render_thread([this] { render(); });
+
+		// sleeps until there is an event, the render thread wakes it up to quit as well
 		while (!glfwWindowShouldClose(GPU_.window_)) {
-			glfwPollEvents();
-			update_time();
-			draw_frame();
+			glfwWaitEvents();
+			publish_input();
 		}
+
+		stop_rendering_ = true;
+		render_thread.join();
+
+		if (render_error_) std::rethrow_exception(render_error_);
+
+		if (job_trace_) {
+			job_trace_->write_json("job_trace.json");
+			std::cout << "task spans written to job_trace.json" << std::endl;
+		}
+	}
+
+	// the counts of the newest frame read back, from any one thread. never waits on the GPU,
+	// the render thread publishes them once they are in, see read_frame_stats
+	const frame_stats& stats() {
+		return stats_channel_.latest();
 	}
 
 private:
+	// main thread
+	void publish_input() {
+		input_.publish({ camera_.get_view(), camera_.get_position(), framebuffer_ });
+	}
+
+	// the render thread, until the main thread stops it. an exception closes the window
+	// and goes to the main thread
+	void render() {
+		try {
+			// the recorder keeps a command pool per job system index, the render thread
+			// records on its own instead of sharing the first worker's
+			jobs_.register_thread();
+
+			apply_present_policy();
+
+			while (!stop_rendering_) {
+				limiter_.wait();
+
+				const auto framebuffer = input_.latest().framebuffer;
+				if (framebuffer != GPU_.framebuffer_extent_) swapchain_stale_ = true;
+
+				if (swapchain_stale_) {
+					swapchain_stale_ = !GPU_.recreate_swapchain(framebuffer);
+
+					// minimized, nothing is drawn or simulated until the window comes back
+					if (swapchain_stale_) {
+						std::this_thread::sleep_for(std::chrono::milliseconds(10));
+						last_frame_time_ = std::chrono::high_resolution_clock::now();
+						continue;
+					}
+
+					// the policy may have changed, and with the display the refresh rate
+					apply_present_policy();
+				}
+
+				while (const auto key = keys_.pop())
+					handle_key(*key);
+
+				update_time();
+
+				if (benchmark_) prepare_benchmark_frame();
+
+				draw_frame();
+
+				if (!first_frame_drawn_) {
+					first_frame_drawn_ = true;
+					std::cout << "first frame after " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - created_).count() << " ms" << std::endl;
+				}
+
+				if (benchmark_) finish_benchmark_frame();
+			}
+		}
+		catch (...) {
+			render_error_ = std::current_exception();
+			close_window();
+		}
+	}
+
+	// from any thread, glfwWaitEvents returns on the empty event
+	void close_window() {
+		glfwSetWindowShouldClose(GPU_.window_, GLFW_TRUE);
+		glfwPostEmptyEvent();
+	}
+
+	// render thread, or the main thread before the render thread starts. the state they
+	// change is the render thread's, other threads go through keys_ instead, see handle_key
+	void set_wind_power(float power) {
+		wind_.power = power;
+		++wind_.epoch;
+	}
+
+	// wakes up sleeping blades rooted within radius of center,
+	// hook for colliders and any other explicit event on the render thread
+	void wake_blades(const glm::vec3& center, float radius) {
+		wake_sphere_ = glm::vec4(center, radius);
+	}
+
+	void set_grass_path(grass_path path) {
+		path_ = path == grass_path::mesh && !GPU_.mesh_shaders_ ? grass_path::tessellation : path;
+	}
+
+	// every benchmark_config in turn along the same camera path, results go to benchmark.csv
+	void start_benchmark() {
+		if (benchmark_) return;
+
+		benchmark_.emplace(benchmark::default_configs(GPU_.mesh_shaders_), tools::params::BENCHMARK_WARMUP_FRAMES, tools::params::BENCHMARK_FRAMES);
+		settings_before_benchmark_ = { path_, sort_blades_ };
+
+		std::cout << "benchmark started" << std::endl;
+	}
+
+	void handle_key(int key) {
+		switch (key) {
+		case GLFW_KEY_UP:	set_wind_power(wind_.power + 2.5f); break;
+		case GLFW_KEY_DOWN:	set_wind_power(glm::max(wind_.power - 2.5f, 0.0f)); break;
+		case GLFW_KEY_SPACE: wake_blades(glm::vec3(0.0f), std::numeric_limits<float>::max()); break;
+		case GLFW_KEY_O:	toggle_sort(); break;
+		case GLFW_KEY_T:	toggle_grass_path(); break;
+		case GLFW_KEY_B:	start_benchmark(); break;
+		case GLFW_KEY_P:	cycle_present_policy(); break;
+		case GLFW_KEY_R:	toggle_dynamic_resolution(); break;
+		}
+	}
+
+	// the newest camera, or the benchmark's orbit
+	void take_input() {
+		const auto& input = input_.latest();
+
+		view_ = benchmark_ ? benchmark_camera_.get_view() : input.view;
+		eye_ = benchmark_ ? benchmark_camera_.get_position() : input.eye;
+	}
+
 	void record_command_buffer(vk::CommandBuffer& commandBuffer, uint32_t image_index) {
 		vk::CommandBufferBeginInfo begin_info{};
 		
 		commandBuffer.begin(begin_info);
+
+		if (GPU_.pipeline_statistics_query_pool_)
+			commandBuffer.resetQueryPool(GPU_.pipeline_statistics_query_pool_, current_frame, 1);
+
+		if (GPU_.scene_timestamp_pool_)
+			commandBuffer.resetQueryPool(GPU_.scene_timestamp_pool_, 2 * current_frame, 2);
 		
+		// the whole scene target is cleared, so that past render_extent_ the depth is far
+		// and the Hi-Z pyramid built from it never occludes anything there
 		vk::RenderPassBeginInfo render_pass_info{};
 		render_pass_info.renderPass = GPU_.render_pass;
-		render_pass_info.framebuffer = GPU_.swapchain_framebuffers[image_index];
+		render_pass_info.framebuffer = GPU_.scene_framebuffer_;
 		render_pass_info.renderArea.offset = vk::Offset2D(0, 0);
 		render_pass_info.renderArea.extent = GPU_.swapchain_extent;
 
@@ -97,40 +302,170 @@ private:
 		render_pass_info.clearValueCount = static_cast<uint32_t>(clear_values.size());
 		render_pass_info.pClearValues = clear_values.data();
 
-		std::vector<vk::BufferMemoryBarrier> compute_barriers(blades.size());
+		// a single barrier on the draw commands, however many blades the pool holds
+		vk::BufferMemoryBarrier compute_barrier{};
+		compute_barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+		compute_barrier.dstAccessMask = vk::AccessFlagBits::eIndirectCommandRead;
+		compute_barrier.srcQueueFamilyIndex = findQueueFamilies(GPU_.physical_device_, GPU_.surface_).compute_family;
+		compute_barrier.dstQueueFamilyIndex = findQueueFamilies(GPU_.physical_device_, GPU_.surface_).graphics_family;
 
-		for (int i = 0; i < blades.size(); ++i) {
-			compute_barriers[i].srcAccessMask = vk::AccessFlagBits::eShaderWrite;
-			compute_barriers[i].dstAccessMask = vk::AccessFlagBits::eIndirectCommandRead;
-			compute_barriers[i].srcQueueFamilyIndex = findQueueFamilies(GPU_.physical_device_, GPU_.surface_).compute_family;
-			compute_barriers[i].dstQueueFamilyIndex = findQueueFamilies(GPU_.physical_device_, GPU_.surface_).graphics_family;
-			
-			compute_barriers[i].buffer = GPU_.indirect_draw_commands_buffer_;
-			compute_barriers[i].offset = 0;
-			compute_barriers[i].size = sizeof(blade_draw_indirect);
-		}
+		compute_barrier.buffer = GPU_.indirect_draw_commands_buffer_;
+		compute_barrier.offset = 0;
+		compute_barrier.size = sizeof(blade_draw_commands);
 
-		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eDrawIndirect, {}, {}, compute_barriers, {});
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eDrawIndirect, {}, {}, compute_barrier, {});
 
-		commandBuffer.beginRenderPass(render_pass_info, vk::SubpassContents::eInline);
-		commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, GPU_.plane_graphics_pipeline_);
+		// the task and mesh shaders read the blades right where the physics pass left them
+		if (path_ == grass_path::mesh) {
+			vk::MemoryBarrier physics_barrier{};
+			physics_barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+			physics_barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
 
-		commandBuffer.bindVertexBuffers(0, { GPU_.plane_vertex_buffer_ }, { 0 });
-		commandBuffer.bindIndexBuffer(GPU_.plane_index_buffer_, 0, vk::IndexType::eUint32);
+			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+				vk::PipelineStageFlagBits::eTaskShaderEXT | vk::PipelineStageFlagBits::eMeshShaderEXT, {}, physics_barrier, {}, {});
+		}
 
 		plane_push_constant plane_push{
-			plane.transform.model_matrix(), //model
-			camera_.get_view(), //view
+			glm::mat4(1.0f), //model, the terrain is built in world space
+			view_, //view
 			{ camera::get_projection(GPU_.aspect_ratio()) } //proj
 		};
 
 		plane_push.projection_matrix[1][1] *= -1;
 
-		commandBuffer.pushConstants(GPU_.plane_pipeline_layout_, vk::ShaderStageFlagBits::eVertex, 0, sizeof(plane_push), &plane_push);
+		// the task shader still tests against the pyramid of the previous frame
+		const glm::mat4 hiz_view_projection = previous_view_projection_;
+
+		// next frame's cull pass reprojects into the depth rendered now, which only
+		// covers the render_extent_ corner of the pyramid
+		previous_view_projection_ = hiz_corner() * plane_push.projection_matrix * plane_push.view_matrix;
+
+		blade_push_constant_data push{
+			{glm::mat4(1.0f)}, //model
+			{glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f))}, //view
+			{ camera::get_projection(GPU_.aspect_ratio()) } //proj
+		};
+		push.view_matrix = view_;
+		push.projection_matrix[1][1] *= -1;
+
+		if (GPU_.pipeline_statistics_query_pool_) {
+			query_sorted_[current_frame] = sort_blades_;
+			query_recorded_[current_frame] = true;
+		}
+
+		if (GPU_.scene_timestamp_pool_) {
+			commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, GPU_.scene_timestamp_pool_, 2 * current_frame);
+			scene_timed_[current_frame] = true;
+			scene_scales_[current_frame] = render_scale_;
+		}
+
+		// the draws are recorded on the workers, the primary buffer only runs them
+		commandBuffer.beginRenderPass(render_pass_info, vk::SubpassContents::eSecondaryCommandBuffers);
+
+		vk::CommandBufferInheritanceInfo inheritance{};
+		inheritance.renderPass = GPU_.render_pass;
+		inheritance.subpass = 0;
+		inheritance.framebuffer = GPU_.scene_framebuffer_;
+
+		const auto draws = recorder_.record(inheritance, draw_jobs(plane_push, push, hiz_view_projection));
+		commandBuffer.executeCommands(draws);
+
+		commandBuffer.endRenderPass();
+
+		if (GPU_.scene_timestamp_pool_)
+			commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, GPU_.scene_timestamp_pool_, 2 * current_frame + 1);
+
+		record_hiz_build(commandBuffer);
+
+		record_upscale(commandBuffer, image_index);
+
+		commandBuffer.end();
+	}
+
+	// maps clip space onto the part of it rendered at render_extent_,
+	// the Hi-Z lookups land on the texels that were actually drawn
+	glm::mat4 hiz_corner() const {
+		const float x = render_extent_.width / static_cast<float>(GPU_.swapchain_extent.width);
+		const float y = render_extent_.height / static_cast<float>(GPU_.swapchain_extent.height);
+
+		glm::mat4 corner(1.0f);
+		corner[0][0] = x;
+		corner[1][1] = y;
+		corner[3][0] = x - 1.0f;
+		corner[3][1] = y - 1.0f;
+
+		return corner;
+	}
+
+	// the rendered corner of the scene target stretched over the swapchain image,
+	// sharpened the more the lower the resolution was
+	void record_upscale(vk::CommandBuffer& commandBuffer, uint32_t image_index) {
+		vk::RenderPassBeginInfo render_pass_info{};
+		render_pass_info.renderPass = GPU_.upscale_render_pass_;
+		render_pass_info.framebuffer = GPU_.swapchain_framebuffers[image_index];
+		render_pass_info.renderArea.offset = vk::Offset2D(0, 0);
+		render_pass_info.renderArea.extent = GPU_.swapchain_extent;
+
+		commandBuffer.beginRenderPass(render_pass_info, vk::SubpassContents::eInline);
+
+		set_viewport(commandBuffer, GPU_.swapchain_extent);
+
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, GPU_.upscale_pipeline_);
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, GPU_.upscale_pipeline_layout_, 0, GPU_.upscale_descriptor_set_, {});
+
+		const float min_scale = resolution_.min_scale();
+		const float sharpening = min_scale < 1.0f ? glm::clamp((1.0f - render_scale_) / (1.0f - min_scale), 0.0f, 1.0f) : 0.0f;
+
+		upscale_push_data push{
+			{ render_extent_.width / static_cast<float>(GPU_.swapchain_extent.width), render_extent_.height / static_cast<float>(GPU_.swapchain_extent.height) },
+			{ 1.0f / GPU_.swapchain_extent.width, 1.0f / GPU_.swapchain_extent.height },
+			tools::params::UPSCALE_SHARPNESS * sharpening
+		};
+
+		commandBuffer.pushConstants(GPU_.upscale_pipeline_layout_, vk::ShaderStageFlagBits::eFragment, 0, sizeof(push), &push);
+		commandBuffer.draw(3, 1, 0, 0);
+
+		commandBuffer.endRenderPass();
+	}
+
+	// the terrain in runs of chunks, the grass in one piece and the cards in runs of tile rows.
+	// the jobs capture what they draw with by value, the workers share nothing else that changes
+	std::vector<parallel_recorder::job> draw_jobs(const plane_push_constant& plane_push, const blade_push_constant_data& push, const glm::mat4& hiz_view_projection) {
+		std::vector<parallel_recorder::job> jobs;
+
+		const uint32_t chunks = static_cast<uint32_t>(chunk_draws_.size());
+
+		for (uint32_t first = 0; first < chunks; first += tools::params::TERRAIN_CHUNKS_PER_JOB) {
+			const uint32_t last = std::min(first + tools::params::TERRAIN_CHUNKS_PER_JOB, chunks);
+			jobs.push_back([=, this](vk::CommandBuffer command_buffer) { record_terrain_draw(command_buffer, plane_push, first, last); });
+		}
+
+		const grass_path path = path_;
+		const bool sorted = sort_blades_;
+		const uint32_t frame = current_frame;
+
+		jobs.push_back([=, this](vk::CommandBuffer command_buffer) { record_grass_draw(command_buffer, push, hiz_view_projection, path, sorted, frame); });
+
+		const uint32_t rows = static_cast<uint32_t>(tools::params::CARD_FIELD_DIM / tools::params::CARD_TILE_DIM);
+
+		for (uint32_t first = 0; first < rows; first += tools::params::CARD_ROWS_PER_JOB) {
+			const uint32_t last = std::min(first + tools::params::CARD_ROWS_PER_JOB, rows);
+			jobs.push_back([=, this](vk::CommandBuffer command_buffer) { record_card_draw(command_buffer, push, first, last); });
+		}
+
+		return jobs;
+	}
 
+	// dynamic state is not inherited, every secondary buffer sets it again.
+	// the scene is drawn at the dynamic resolution
+	void set_viewport(vk::CommandBuffer commandBuffer) const {
+		set_viewport(commandBuffer, render_extent_);
+	}
+
+	void set_viewport(vk::CommandBuffer commandBuffer, vk::Extent2D extent) const {
 		vk::Viewport viewport{};
-		viewport.height = static_cast<float>(GPU_.swapchain_extent.height);
-		viewport.width = static_cast<float>(GPU_.swapchain_extent.width);
+		viewport.height = static_cast<float>(extent.height);
+		viewport.width = static_cast<float>(extent.width);
 		viewport.x = 0.0f;
 		viewport.y = 0.0f;
 		viewport.minDepth = 0.0f;
@@ -140,9 +475,98 @@ private:
 
 		vk::Rect2D scissor{};
 		scissor.offset = vk::Offset2D{ 0, 0 };
-		scissor.extent = GPU_.swapchain_extent;
+		scissor.extent = extent;
 
 		commandBuffer.setScissor(0, scissor);
+	}
+
+	// the lod buckets or the task shader, inside the fragment invocation query
+	void record_grass_draw(vk::CommandBuffer commandBuffer, const blade_push_constant_data& push, const glm::mat4& hiz_view_projection, grass_path path, bool sorted, uint32_t frame) const {
+		set_viewport(commandBuffer);
+
+		commandBuffer.bindVertexBuffers(0, sorted ? GPU_.sorted_blades_buffer_ : GPU_.culled_blades_buffer, { 0 });
+
+		commandBuffer.pushConstants(GPU_.grass_pipeline_layout_, vk::ShaderStageFlagBits::eVertex, 0, sizeof(glm::mat4), &push);
+
+		// the strips of the far lod read the matrices in the vertex shader
+		glm::mat4 matrices[] = { push.view_matrix, push.projection_matrix };
+		commandBuffer.pushConstants(GPU_.grass_pipeline_layout_, vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eTessellationEvaluation, sizeof(glm::mat4), 2 * sizeof(glm::mat4), matrices);
+
+		if (GPU_.pipeline_statistics_query_pool_)
+			commandBuffer.beginQuery(GPU_.pipeline_statistics_query_pool_, frame, {});
+
+		if (path == grass_path::mesh) record_mesh_draw(commandBuffer, push, hiz_view_projection);
+
+		const uint32_t strips = strip_lods(path);
+
+		for (uint32_t lod = 0; lod < lod_count && path != grass_path::mesh; ++lod) {
+			const auto& pipeline = (strips & (1u << lod)) ? GPU_.grass_strip_pipelines_[lod] : GPU_.grass_tessellation_pipelines_[lod];
+			commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+
+			const vk::DeviceSize command_offset = offsetof(blade_draw_commands, lods) + lod * sizeof(blade_draw_indirect);
+			const vk::DeviceSize count_offset = offsetof(blade_draw_commands, draw_counts) + lod * sizeof(uint32_t);
+
+			// an empty bucket costs no draw at all, without the count buffer it is a zero-sized one
+			if (GPU_.vulkan12_features_.drawIndirectCount)
+				commandBuffer.drawIndirectCount(GPU_.indirect_draw_commands_buffer_, command_offset, GPU_.indirect_draw_commands_buffer_, count_offset, 1, sizeof(blade_draw_indirect));
+			else
+				commandBuffer.drawIndirect(GPU_.indirect_draw_commands_buffer_, command_offset, 1, sizeof(blade_draw_indirect));
+		}
+
+		if (GPU_.pipeline_statistics_query_pool_)
+			commandBuffer.endQuery(GPU_.pipeline_statistics_query_pool_, frame);
+	}
+
+	// a task workgroup per COMPUTE_WORKGROUP_SIZE blades, culling happens in there
+	void record_mesh_draw(vk::CommandBuffer commandBuffer, const blade_push_constant_data& push, const glm::mat4& hiz_view_projection) const {
+		const blade_mesh_push_data mesh_push{ push.view_matrix, push.projection_matrix, hiz_view_projection, GPU_.blade_buffers_address_ };
+
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, GPU_.mesh_pipeline_);
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, GPU_.mesh_pipeline_layout_, 0, GPU_.mesh_descriptor_set_, {});
+		commandBuffer.pushConstants(GPU_.mesh_pipeline_layout_, vk::ShaderStageFlagBits::eTaskEXT | vk::ShaderStageFlagBits::eMeshEXT, 0, sizeof(mesh_push), &mesh_push);
+
+		const uint32_t task_groups = (GPU_.blades_num_ + COMPUTE_WORKGROUP_SIZE - 1) / COMPUTE_WORKGROUP_SIZE;
+		GPU_.cmd_draw_mesh_tasks_(commandBuffer, task_groups, 1, 1);
+	}
+
+	// the chunks in view this frame, before anything is recorded: the terrain and the
+	// cards draw them, the cull pass skips the grass tiles of all the others
+	void update_visibility() {
+		glm::mat4 projection = camera::get_projection(GPU_.aspect_ratio());
+		projection[1][1] *= -1;
+
+		const auto frustum = camera::frustum_planes(projection * view_);
+		const glm::vec3 eye = eye_;
+
+		// the grass tiles on a worker meanwhile, the blades stick out of their chunk's bounds
+		auto grass_tiles = jobs_.submit("grass tile visibility", [&] {
+			const auto grass_chunks = terrain_.visible_chunks(
+				frustum, eye, tools::params::STREAM_RADIUS, tools::params::TERRAIN_LOD_DISTANCE, tools::params::STREAM_TILE_MARGIN);
+
+			std::fill(visible_grass_tiles_.begin(), visible_grass_tiles_.end(), false);
+			for (const auto& draw : grass_chunks)
+				visible_grass_tiles_[draw.chunk] = true;
+		});
+
+		chunk_draws_ = terrain_.visible_chunks(frustum, eye, tools::params::TERRAIN_VIEW_DISTANCE, tools::params::TERRAIN_LOD_DISTANCE);
+
+		std::fill(visible_chunks_.begin(), visible_chunks_.end(), false);
+		for (const auto& draw : chunk_draws_)
+			visible_chunks_[draw.chunk] = true;
+
+		jobs_.wait(grass_tiles);
+	}
+
+	// one draw per visible chunk in [first, last), the index range of its lod and its own vertex offset
+	void record_terrain_draw(vk::CommandBuffer commandBuffer, const plane_push_constant& plane_push, uint32_t first, uint32_t last) const {
+		set_viewport(commandBuffer);
+
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, GPU_.plane_graphics_pipeline_);
+
+		commandBuffer.bindVertexBuffers(0, { GPU_.plane_vertex_buffer_ }, { 0 });
+		commandBuffer.bindIndexBuffer(GPU_.plane_index_buffer_, 0, vk::IndexType::eUint32);
+
+		commandBuffer.pushConstants(GPU_.plane_pipeline_layout_, vk::ShaderStageFlagBits::eVertex, 0, sizeof(plane_push), &plane_push);
 
 		commandBuffer.bindDescriptorSets(
 			vk::PipelineBindPoint::eGraphics,
@@ -152,61 +576,151 @@ private:
 			{}
 		);
 
-		commandBuffer.drawIndexed(static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
+		for (uint32_t i = first; i < last; ++i) {
+			const auto& draw = chunk_draws_[i];
+			const auto lod = terrain_.lod(draw.lod);
+			const int32_t vertex_offset = static_cast<int32_t>(draw.chunk * terrain_.vertices_per_chunk());
 
-		blade_push_constant_data push{
-			{glm::mat4(1.0f)}, //model
-			{glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f))}, //view
-			{ camera::get_projection(GPU_.aspect_ratio()) } //proj
+			commandBuffer.drawIndexed(lod.index_count, 1, lod.first_index, vertex_offset, 0);
+		}
+	}
+
+	// the far field cards of the tile rows in [first_row, last_row), one instanced draw per run of visible
+	// tiles in a row. a tile is skipped when its terrain chunk is not visible or it lies entirely before the fade band
+	void record_card_draw(vk::CommandBuffer commandBuffer, const blade_push_constant_data& push, uint32_t first_row, uint32_t last_row) const {
+		set_viewport(commandBuffer);
+
+		// set before the draw jobs start, it does not change while they run
+		const glm::vec3 eye = eye_;
+		const blade_card_push_data card_push{ push.view_matrix, push.projection_matrix, glm::vec4(eye, 1.0f) };
+
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, GPU_.card_pipeline_);
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, GPU_.card_pipeline_layout_, 0, GPU_.card_descriptor_set_, {});
+		commandBuffer.pushConstants(GPU_.card_pipeline_layout_, vk::ShaderStageFlagBits::eVertex, 0, sizeof(card_push), &card_push);
+		commandBuffer.bindVertexBuffers(0, GPU_.card_buffer_, { 0 });
+
+		const float field = tools::params::CARD_FIELD_DIM;
+		const float tile = tools::params::CARD_TILE_DIM;
+		const uint32_t tiles_per_row = static_cast<uint32_t>(field / tile);
+		const uint32_t cards_per_tile = tools::params::CARDS_PER_TILE;
+
+		// the tiles are the terrain chunks
+		static_assert(tools::params::CARD_TILE_DIM == tools::params::TERRAIN_CHUNK_DIM && tools::params::CARD_FIELD_DIM == tools::params::TERRAIN_DIM);
+
+		auto visible = [&](uint32_t row, uint32_t column) {
+			if (!visible_chunks_[row * tiles_per_row + column]) return false;
+
+			const glm::vec2 tile_min{ column * tile - 0.5f * field, row * tile - 0.5f * field };
+			const glm::vec2 tile_max = tile_min + tile;
+
+			// the corner farthest from the eye decides whether any card has faded in
+			const glm::vec2 farthest = glm::max(glm::abs(tile_min - glm::vec2(eye.x, eye.z)), glm::abs(tile_max - glm::vec2(eye.x, eye.z)));
+			return glm::length(farthest) >= tools::params::CARD_FADE_START;
 		};
-		push.view_matrix = camera_.get_view();
-		push.projection_matrix[1][1] *= -1;
 
-		commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, GPU_.grass_pipeline_);
-		
-		commandBuffer.bindVertexBuffers(0, GPU_.culled_blades_buffer, { 0 });
+		for (uint32_t row = first_row; row < last_row; ++row) {
+			uint32_t column = 0;
 
-		commandBuffer.pushConstants(GPU_.grass_pipeline_layout_, vk::ShaderStageFlagBits::eVertex, 0, sizeof(glm::mat4), &push);
+			while (column < tiles_per_row) {
+				if (!visible(row, column)) {
+					++column;
+					continue;
+				}
 
-		glm::mat4 matrices[] = { push.view_matrix, push.projection_matrix };
-		commandBuffer.pushConstants(GPU_.grass_pipeline_layout_, vk::ShaderStageFlagBits::eTessellationEvaluation, sizeof(glm::mat4), 2 * sizeof(glm::mat4), matrices);
+				const uint32_t first = column;
+				while (column < tiles_per_row && visible(row, column)) ++column;
 
-		commandBuffer.drawIndirect(GPU_.indirect_draw_commands_buffer_, 0, 1, sizeof(blade_draw_indirect));
+				const uint32_t first_card = (row * tiles_per_row + first) * cards_per_tile;
+				commandBuffer.draw(4, (column - first) * cards_per_tile, 0, first_card);
+			}
+		}
+	}
 
-		commandBuffer.endRenderPass();
-		commandBuffer.end();
+	void record_hiz_build(vk::CommandBuffer& commandBuffer) {
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, GPU_.hiz_pipeline_);
+
+		for (uint32_t level = 0; level < GPU_.hiz_levels_; ++level) {
+			const uint32_t width = std::max(GPU_.swapchain_extent.width >> level, 1u);
+			const uint32_t height = std::max(GPU_.swapchain_extent.height >> level, 1u);
+
+			commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, GPU_.hiz_pipeline_layout_, 0, GPU_.hiz_descriptor_sets_[level], {});
+			commandBuffer.dispatch((width + 7) / 8, (height + 7) / 8, 1);
+
+			// the next level reduces this one
+			vk::ImageMemoryBarrier level_barrier{};
+			level_barrier.image = GPU_.hiz_image_;
+			level_barrier.oldLayout = vk::ImageLayout::eGeneral;
+			level_barrier.newLayout = vk::ImageLayout::eGeneral;
+			level_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			level_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			level_barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+			level_barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+			level_barrier.subresourceRange = vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, level, 1, 0, 1 };
+
+			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, {}, {}, level_barrier);
+		}
 	}
 
 	void update_time() {
-		static auto start_time = std::chrono::high_resolution_clock::now();
 		auto current_time = std::chrono::high_resolution_clock::now();
 
-		time_.delta_time = std::chrono::duration<float, std::chrono::seconds::period>(current_time - start_time).count();
+		time_.delta_time = std::chrono::duration<float, std::chrono::seconds::period>(current_time - last_frame_time_).count();
 		time_.total_time += time_.delta_time;
 
-		start_time = current_time;
+		last_frame_time_ = current_time;
 	}
 
 	void record_compute_command_buffer() {
 		vk::CommandBufferBeginInfo begin_info{};
-		begin_info.flags = vk::CommandBufferUsageFlagBits::eSimultaneousUse;
 
-		GPU_.compute_command_buffer_.begin(begin_info);
+		auto& command_buffer = GPU_.compute_command_buffers_[current_frame];
 
-		GPU_.compute_command_buffer_.bindPipeline(vk::PipelineBindPoint::eCompute, GPU_.compute_pipeline_);
+		command_buffer.begin(begin_info);
 
 		blade_compute_push_data push{
-			camera_.get_view(),
+			view_,
 			glm::perspective(glm::radians(90.0f), GPU_.aspect_ratio(), 0.1f, 10.0f),
+			previous_view_projection_,
 			time_.delta_time,
-			time_.total_time
+			time_.total_time,
+			wind_.power,
+			wind_.epoch,
+			strip_lods(path_),
+			wake_sphere_,
+			GPU_.blade_buffers_address_
 		};
 
 		push.projection_matrix[1][1] *= -1;
 
-		GPU_.compute_command_buffer_.pushConstants(GPU_.compute_pipeline_layout_, vk::ShaderStageFlagBits::eCompute, 0, sizeof(push), &push);
+		// wake-ups are one-shot events
+		wake_sphere_ = glm::vec4(0.0f);
+
+		record_tile_uploads(command_buffer);
+
+		if (fp16_report_ && fp16_report_->phase == fp16_report_phase::copying) record_fp16_reference_copy(command_buffer);
+
+		// while tuning, a candidate's kernels run instead and both dispatches are timed
+		auto cull_pipeline = GPU_.compute_pipeline_;
+		auto physics_pipeline = GPU_.physics_pipeline_;
+		uint32_t workgroup_size = GPU_.workgroup_sizes_.cull;
+		uint32_t physics_workgroup_size = GPU_.workgroup_sizes_.physics;
+
+		if (timed_candidate_) {
+			cull_pipeline = GPU_.tuning_pipelines_[*timed_candidate_].cull;
+			physics_pipeline = GPU_.tuning_pipelines_[*timed_candidate_].physics;
+			workgroup_size = tuner_->candidates()[*timed_candidate_];
+			physics_workgroup_size = workgroup_size;
+
+			command_buffer.resetQueryPool(GPU_.compute_timestamp_pool_, 0, COMPUTE_TIMESTAMPS);
+		}
+
+		const auto timestamp = [&](uint32_t query) {
+			if (timed_candidate_) command_buffer.writeTimestamp(vk::PipelineStageFlagBits::eComputeShader, GPU_.compute_timestamp_pool_, query);
+		};
+
+		command_buffer.pushConstants(GPU_.compute_pipeline_layout_, vk::ShaderStageFlagBits::eCompute, 0, sizeof(push), &push);
 
-		GPU_.compute_command_buffer_.bindDescriptorSets(
+		command_buffer.bindDescriptorSets(
 			vk::PipelineBindPoint::eCompute, 
 			GPU_.compute_pipeline_layout_, 
 			0, 
@@ -215,66 +729,606 @@ private:
 			0, 
 			nullptr
 		);
-		
-		const int workgroup_size = 32;
-		const int groupcount = ((blades.size()) / workgroup_size) + 1;
 
-		uint32_t count = (blades.size() + workgroup_size - 1) / workgroup_size;
+		// physics only for the blades the previous cull pass found awake. it counted the groups
+		// for its own physics workgroup size, if that was larger, as when the tuning ends on a
+		// smaller winner, they fall short: the whole pool is dispatched instead, for this frame
+		// only, and the threads past the awake count return right away
+		command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, physics_pipeline);
+		timestamp(0);
+
+		if (awake_groups_size_ > physics_workgroup_size)
+			command_buffer.dispatch((GPU_.blades_num_ + physics_workgroup_size - 1) / physics_workgroup_size, 1, 1);
+		else
+			command_buffer.dispatchIndirect(GPU_.awake_blades_buffer_, 0);
+
+		timestamp(1);
+
+		if (fp16_report_ && fp16_report_->phase == fp16_report_phase::running) record_fp16_reference(command_buffer, push);
+
+		vk::MemoryBarrier physics_barrier{};
+		physics_barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eIndirectCommandRead;
+		physics_barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite | vk::AccessFlagBits::eTransferWrite;
+
+		command_buffer.pipelineBarrier(
+			vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eDrawIndirect,
+			vk::PipelineStageFlagBits::eComputeShader | vk::PipelineStageFlagBits::eTransfer,
+			{}, physics_barrier, {}, {}
+		);
+
+		// the cull pass compacts the awake list for the next frame from scratch
+		const blade_awake_list empty_list{ 0, 1, 1, 0, 0 };
+		command_buffer.updateBuffer(GPU_.awake_blades_buffer_, 0, sizeof(empty_list), &empty_list);
+
+		// and fills the lod buckets from scratch
+		const auto empty_draws = blade_draw_commands::empty(GPU_.bucket_capacity_, strip_lods(path_), STRIP_VERTICES);
+		command_buffer.updateBuffer(GPU_.indirect_draw_commands_buffer_, 0, sizeof(empty_draws), &empty_draws);
+		command_buffer.fillBuffer(GPU_.cull_stats_buffer_, 0, sizeof(blade_cull_stats), 0);
+		command_buffer.fillBuffer(GPU_.depth_buckets_buffer_, 0, sizeof(uint32_t) * DEPTH_BUCKET_COUNT * lod_count, 0);
+
+		// also covers the Hi-Z pyramid built at the end of the previous frame
+		vk::MemoryBarrier reset_barrier{};
+		reset_barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite | vk::AccessFlagBits::eShaderWrite;
+		reset_barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+
+		command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, reset_barrier, {}, {});
+
+		command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, cull_pipeline);
+
+		// a row of workgroups per shard, so a workgroup never spans two of them
+		uint32_t count = (GPU_.blades_per_shard_ + workgroup_size - 1) / workgroup_size;
 		
-		GPU_.compute_command_buffer_.dispatch(count, 1, 1);
+		timestamp(2);
+		command_buffer.dispatch(count, GPU_.shard_count_, 1);
+		timestamp(3);
+
+		awake_groups_size_ = physics_workgroup_size;
+
+		// the mesh path draws straight from the input buffer, nothing to sort
+		if (sort_blades_ && path_ != grass_path::mesh) record_sort(command_buffer);
+
+		record_stats_readback(command_buffer);
+
+		command_buffer.end();
+	}
+
+	void start_workgroup_tuning() {
+		tuner_.emplace(GPU_.workgroup_size_candidates(), tools::params::WORKGROUP_TUNING_WARMUP_FRAMES, tools::params::WORKGROUP_TUNING_FRAMES);
+		GPU_.build_tuning_pipelines(tuner_->candidates());
+
+		std::cout << "tuning the grass kernels' workgroup sizes, " << tuner_->candidates().size() << " candidates" << std::endl;
+	}
+
+	// the compute queue is idle here, the timestamps of its last submission are in
+	void update_workgroup_tuning() {
+		if (!tuner_) return;
+
+		if (timed_candidate_) {
+			std::array<uint64_t, COMPUTE_TIMESTAMPS> ticks{};
+
+			const auto result = GPU_.logical_device_.getQueryPoolResults(
+				GPU_.compute_timestamp_pool_, 0, COMPUTE_TIMESTAMPS, sizeof(ticks), ticks.data(), sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+
+			const auto milliseconds = [&](uint32_t begin) {
+				return static_cast<double>(ticks[begin + 1] - ticks[begin]) * GPU_.timestamp_period_ * 1e-6;
+			};
+
+			if (result == vk::Result::eSuccess) tuner_->add_sample(*timed_candidate_, milliseconds(2), milliseconds(0));
+
+			timed_candidate_.reset();
+		}
+
+		if (tuner_->finished()) {
+			finish_workgroup_tuning();
+			return;
+		}
+
+		// the warmup only counts once every candidate can run
+		if (!GPU_.tuning_build_->done()) return;
+
+		timed_candidate_ = tuner_->candidate();
+		tuner_->next_frame();
+	}
+
+	void finish_workgroup_tuning() {
+		const auto winners = tuner_->winners();
+
+		GPU_.set_workgroup_sizes(winners);
+		GPU_.destroy_tuning_pipelines();
+
+		tuner_.reset();
+
+		std::cout << "workgroup sizes: cull " << winners.cull << ", physics " << winners.physics << std::endl;
+	}
+
+	// the compute queue is idle here. the reference starts once no workgroup tuning swaps
+	// kernels anymore, and what was read back at the end of the run is compared
+	void update_fp16_report() {
+		if (!fp16_report_) return;
+
+		switch (fp16_report_->phase) {
+		case fp16_report_phase::waiting:
+			if (tuner_) return;
+
+			GPU_.create_fp16_reference();
+			fp16_report_->phase = fp16_report_phase::copying;
+			break;
+
+		case fp16_report_phase::read_back: {
+			const auto readback = static_cast<const blade*>(GPU_.fp16_reference_->readback_mapped);
+			const auto states = reinterpret_cast<const blade_state*>(readback + 2 * GPU_.blades_num_);
+
+			precision_report(
+				std::span(readback, GPU_.blades_num_),
+				std::span(readback + GPU_.blades_num_, GPU_.blades_num_),
+				std::span(states, GPU_.blades_num_),
+				std::span(states + GPU_.blades_num_, GPU_.blades_num_),
+				streamer_.table(),
+				tools::params::BLADES_PER_TILE
+			).print(fp16_report_->simulated_seconds);
+
+			GPU_.destroy_fp16_reference();
+			fp16_report_.reset();
+			break;
+		}
+
+		default:
+			break;
+		}
+	}
+
+	// the reference starts out as the live pool, tiles uploaded this frame included
+	void record_fp16_reference_copy(vk::CommandBuffer& command_buffer) {
+		const auto& reference = *GPU_.fp16_reference_;
+
+		vk::MemoryBarrier upload_barrier{};
+		upload_barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite | vk::AccessFlagBits::eShaderWrite;
+		upload_barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite;
+
+		command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer, {}, upload_barrier, {}, {});
+
+		for (uint32_t shard = 0; shard < GPU_.shard_count_; ++shard) {
+			const uint32_t blades = std::min(GPU_.blades_per_shard_, GPU_.blades_num_ - shard * GPU_.blades_per_shard_);
+
+			command_buffer.copyBuffer(GPU_.blade_shards_[shard], reference.blade_shards[shard], vk::BufferCopy(0, 0, sizeof(blade) * blades));
+			command_buffer.copyBuffer(GPU_.state_shards_[shard], reference.state_shards[shard], vk::BufferCopy(0, 0, sizeof(blade_state) * blades));
+		}
+
+		vk::MemoryBarrier copy_barrier{};
+		copy_barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+		copy_barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+
+		command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, copy_barrier, {}, {});
+
+		fp16_report_->phase = fp16_report_phase::running;
+	}
+
+	// the fp32 kernel on the awake blades of the live pool, writing the reference pool.
+	// once enough time is simulated both pools are read back for update_fp16_report
+	void record_fp16_reference(vk::CommandBuffer& command_buffer, const blade_compute_push_data& push) {
+		const auto& reference = *GPU_.fp16_reference_;
+
+		auto reference_push = push;
+		reference_push.buffers = reference.address;
+
+		command_buffer.pushConstants(GPU_.compute_pipeline_layout_, vk::ShaderStageFlagBits::eCompute, 0, sizeof(reference_push), &reference_push);
+		command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, reference.physics);
+		command_buffer.dispatchIndirect(GPU_.awake_blades_buffer_, 0);
+
+		// the cull pass that follows reads the live table
+		command_buffer.pushConstants(GPU_.compute_pipeline_layout_, vk::ShaderStageFlagBits::eCompute, 0, sizeof(push), &push);
+
+		fp16_report_->simulated_seconds += push.delta_time;
+		if (fp16_report_->simulated_seconds < tools::params::FP16_REPORT_SECONDS) return;
+
+		vk::MemoryBarrier physics_barrier{};
+		physics_barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+		physics_barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+
+		command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer, {}, physics_barrier, {}, {});
+
+		const vk::DeviceSize reference_offset = sizeof(blade) * GPU_.blades_num_;
+		const vk::DeviceSize states_offset = 2 * sizeof(blade) * GPU_.blades_num_;
+		const vk::DeviceSize reference_states_offset = states_offset + sizeof(blade_state) * GPU_.blades_num_;
+
+		for (uint32_t shard = 0; shard < GPU_.shard_count_; ++shard) {
+			const uint32_t blades = std::min(GPU_.blades_per_shard_, GPU_.blades_num_ - shard * GPU_.blades_per_shard_);
+			const vk::DeviceSize offset = sizeof(blade) * shard * GPU_.blades_per_shard_;
+			const vk::DeviceSize state_offset = sizeof(blade_state) * shard * GPU_.blades_per_shard_;
+
+			command_buffer.copyBuffer(GPU_.blade_shards_[shard], reference.readback, vk::BufferCopy(0, offset, sizeof(blade) * blades));
+			command_buffer.copyBuffer(reference.blade_shards[shard], reference.readback, vk::BufferCopy(0, reference_offset + offset, sizeof(blade) * blades));
+
+			// whether the two kernels put the same blades to sleep
+			command_buffer.copyBuffer(GPU_.state_shards_[shard], reference.readback, vk::BufferCopy(0, states_offset + state_offset, sizeof(blade_state) * blades));
+			command_buffer.copyBuffer(reference.state_shards[shard], reference.readback, vk::BufferCopy(0, reference_states_offset + state_offset, sizeof(blade_state) * blades));
+		}
+
+		vk::MemoryBarrier readback_barrier{};
+		readback_barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+		readback_barrier.dstAccessMask = vk::AccessFlagBits::eHostRead;
+
+		command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, readback_barrier, {}, {});
+
+		fp16_report_->phase = fp16_report_phase::read_back;
+	}
+
+	// the tiles the workers have finished go straight into their pool slots. the frame slot's
+	// part of the staging buffer is free again, its previous frame is done by now
+	void record_tile_uploads(vk::CommandBuffer& command_buffer) {
+		const auto uploads = streamer_.update(eye_, tools::params::STREAM_RADIUS, tools::params::STREAM_UPLOADS_PER_FRAME);
+
+		const vk::DeviceSize slot_size = sizeof(blade) * tools::params::BLADES_PER_TILE;
+		const vk::DeviceSize staging_offset = GPU_.tile_staging_offset(current_frame);
+		auto staging = static_cast<char*>(GPU_.tile_staging_mapped_) + staging_offset;
+
+		for (size_t i = 0; i < uploads.size(); ++i) {
+			const auto& upload = uploads[i];
+			const vk::DeviceSize size = sizeof(blade) * upload.blades.size();
+
+			// shards hold whole slots
+			const uint32_t first_blade = upload.slot * tools::params::BLADES_PER_TILE;
+			const uint32_t shard = first_blade / GPU_.blades_per_shard_;
+			const uint32_t shard_offset = first_blade % GPU_.blades_per_shard_;
+
+			std::memcpy(staging + i * slot_size, upload.blades.data(), size);
+			command_buffer.copyBuffer(GPU_.tile_staging_buffer_, GPU_.blade_shards_[shard], vk::BufferCopy(staging_offset + i * slot_size, sizeof(blade) * shard_offset, size));
+
+			// a new tile starts awake
+			command_buffer.fillBuffer(GPU_.state_shards_[shard], sizeof(blade_state) * shard_offset, sizeof(blade_state) * tools::params::BLADES_PER_TILE, 0);
+
+			// the fp32 reference gets the same tiles
+			if (const auto& reference = GPU_.fp16_reference_) {
+				command_buffer.copyBuffer(GPU_.tile_staging_buffer_, reference->blade_shards[shard], vk::BufferCopy(staging_offset + i * slot_size, sizeof(blade) * shard_offset, size));
+				command_buffer.fillBuffer(reference->state_shards[shard], sizeof(blade_state) * shard_offset, sizeof(blade_state) * tools::params::BLADES_PER_TILE, 0);
+			}
+		}
+
+		auto table = streamer_.table();
+		for (auto& slot : table)
+			slot.visible = slot.blade_count > 0 && visible_grass_tiles_[slot.tile];
+
+		command_buffer.updateBuffer(GPU_.tile_table_buffer_, 0, sizeof(grass_tile_slot) * table.size(), table.data());
+
+		vk::MemoryBarrier upload_barrier{};
+		upload_barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+		upload_barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+
+		command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, {}, upload_barrier, {}, {});
+	}
+
+	// bucket sort of the visible blades on view distance for early-z
+	void record_sort(vk::CommandBuffer& command_buffer) {
+		blade_sort_push_data push{ glm::vec4(eye_, 1.0f), GPU_.bucket_capacity_, strip_lods(path_), GPU_.blade_buffers_address_ };
+
+		command_buffer.pushConstants(GPU_.sort_pipeline_layout_, vk::ShaderStageFlagBits::eCompute, 0, sizeof(push), &push);
+
+		vk::MemoryBarrier pass_barrier{};
+		pass_barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+		pass_barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+
+		// every lod range is sorted on its own
+		const uint32_t blade_groups = (GPU_.bucket_capacity_ * lod_count + SORT_WORKGROUP_SIZE - 1) / SORT_WORKGROUP_SIZE;
+		const uint32_t group_counts[] = { blade_groups, lod_count, blade_groups };
+
+		for (uint32_t pass = 0; pass < GPU_.sort_pipelines_.size(); ++pass) {
+			command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, {}, pass_barrier, {}, {});
+
+			command_buffer.bindPipeline(vk::PipelineBindPoint::eCompute, GPU_.sort_pipelines_[pass]);
+			command_buffer.dispatch(group_counts[pass], 1, 1);
+		}
+	}
+
+	// the counts of this frame into the frame slot's readback block, read once the slot comes round again
+	void record_stats_readback(vk::CommandBuffer& command_buffer) {
+		vk::MemoryBarrier count_barrier{};
+		count_barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+		count_barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+
+		command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer, {}, count_barrier, {}, {});
+
+		const vk::DeviceSize offset = GPU_.stats_readback_offset(current_frame);
+
+		command_buffer.copyBuffer(GPU_.indirect_draw_commands_buffer_, GPU_.stats_readback_buffer_,
+			vk::BufferCopy{ 0, offset + offsetof(frame_stats_block, draws), sizeof(blade_draw_commands) });
+		command_buffer.copyBuffer(GPU_.awake_blades_buffer_, GPU_.stats_readback_buffer_,
+			vk::BufferCopy{ 0, offset + offsetof(frame_stats_block, awake), sizeof(blade_awake_list) });
+		command_buffer.copyBuffer(GPU_.cull_stats_buffer_, GPU_.stats_readback_buffer_,
+			vk::BufferCopy{ 0, offset + offsetof(frame_stats_block, cull), sizeof(blade_cull_stats) });
+
+		vk::MemoryBarrier host_barrier{};
+		host_barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+		host_barrier.dstAccessMask = vk::AccessFlagBits::eHostRead;
+
+		command_buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, {}, host_barrier, {}, {});
+
+		stats_strip_lods_[current_frame] = strip_lods(path_);
+	}
+
+	// non-blocking. this slot's graphics work is done, and it waited for its compute work,
+	// so the block is in. the check only guards against a slot that never got submitted
+	void read_frame_stats() {
+		const uint64_t value = stats_values_[current_frame];
+		if (value == 0 || !GPU_.timeline_reached(GPU_.compute_timeline_, value)) return;
 
-		GPU_.compute_command_buffer_.end();
+		stats_values_[current_frame] = 0;
+		stats_ = frame_stats::from_block(GPU_.read_stats_block(current_frame), value, stats_strip_lods_[current_frame], GPU_.bucket_capacity_);
+		stats_channel_.publish(stats_);
+
+		const auto now = std::chrono::steady_clock::now();
+		if (!stats_report_ || now - last_stats_report_ < std::chrono::duration<float>(tools::params::STATS_REPORT_SECONDS)) return;
+
+		last_stats_report_ = now;
+
+		std::cout << "visible blades " << stats_.visible_total
+			<< " (near " << stats_.visible_blades[near_lod] << ", mid " << stats_.visible_blades[mid_lod] << ", far " << stats_.visible_blades[far_lod] << ")"
+			<< ", awake " << stats_.awake_blades << ", asleep " << stats_.asleep_blades << std::endl;
+
+		if (!GPU_.cull_stats()) return;
+
+		const auto& cull = stats_.cull;
+		std::cout << "cull tests: " << cull.tested << " tested, would reject orientation " << cull.orientation_culled
+			<< ", frustum " << cull.frustum_culled << ", distance " << cull.distance_culled
+			<< "; rejected card handover " << cull.card_handover << ", occlusion " << cull.occlusion_culled
+			<< "; " << cull.survived << " survived" << std::endl;
+	}
+
+	// non-blocking, the fence of this frame slot has already been waited on
+	void read_pipeline_statistics() {
+		if (!GPU_.pipeline_statistics_query_pool_ || !query_recorded_[current_frame]) return;
+
+		auto result = GPU_.logical_device_.getQueryPoolResult<uint64_t>(
+			GPU_.pipeline_statistics_query_pool_, current_frame, 1, sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+
+		if (result.result != vk::Result::eSuccess) return;
+
+		last_fragment_invocations_ = result.value;
+
+		auto& average = query_sorted_[current_frame] ? fragment_invocations_.sorted : fragment_invocations_.unsorted;
+		average = average == 0.0 ? result.value : 0.95 * average + 0.05 * result.value;
+	}
+
+	// non-blocking as well. the scale follows the GPU time of the scene pass, see resolution_controller
+	void update_render_scale() {
+		if (GPU_.scene_timestamp_pool_ && scene_timed_[current_frame]) {
+			std::array<uint64_t, 2> ticks{};
+
+			const auto result = GPU_.logical_device_.getQueryPoolResults(
+				GPU_.scene_timestamp_pool_, 2 * current_frame, 2, sizeof(ticks), ticks.data(), sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+
+			if (result == vk::Result::eSuccess) {
+				scene_timed_[current_frame] = false;
+				last_scene_ms_ = static_cast<double>(ticks[1] - ticks[0]) * GPU_.timestamp_period_ * 1e-6;
+
+				if (dynamic_resolution_) resolution_.add_sample(last_scene_ms_, scene_scales_[current_frame]);
+			}
+		}
+
+		// the benchmark compares the configurations at the full resolution
+		render_scale_ = dynamic_resolution_ && !benchmark_ ? resolution_.scale() : 1.0f;
+		render_extent_ = scaled_extent(GPU_.swapchain_extent, render_scale_);
+	}
+
+	void toggle_dynamic_resolution() {
+		dynamic_resolution_ = !dynamic_resolution_;
+		resolution_.reset();
+
+		std::cout << "dynamic resolution " << (dynamic_resolution_ ? "on" : "off") << ", scene pass " << last_scene_ms_ << " ms" << std::endl;
+	}
+
+	void toggle_sort() {
+		sort_blades_ = !sort_blades_;
+
+		const auto& invocations = fragment_invocations_;
+		std::cout << "grass fragment invocations: sorted " << static_cast<uint64_t>(invocations.sorted)
+			<< ", unsorted " << static_cast<uint64_t>(invocations.unsorted);
+
+		if (invocations.sorted > 0.0 && invocations.unsorted > 0.0)
+			std::cout << " (" << 100.0 * (1.0 - invocations.sorted / invocations.unsorted) << "% saved by sorting)";
+
+		std::cout << std::endl;
+	}
+
+	void toggle_grass_path() {
+		switch (path_) {
+		case grass_path::tessellation:	path_ = grass_path::strips; break;
+		case grass_path::strips:		path_ = GPU_.mesh_shaders_ ? grass_path::mesh : grass_path::tessellation; break;
+		default:						path_ = grass_path::tessellation; break;
+		}
+
+		std::cout << "grass path: " << to_string(path_) << std::endl;
+	}
+
+	void prepare_benchmark_frame() {
+		const auto& config = benchmark_->config();
+		path_ = config.path;
+		sort_blades_ = config.sort;
+
+		// one orbit per run, so that every configuration sees the same views
+		const uint32_t run_frames = tools::params::BENCHMARK_WARMUP_FRAMES + tools::params::BENCHMARK_FRAMES;
+		benchmark_camera_.set_orbit(360.0f * benchmark_->frame() / run_frames, -20.0f, 15.0f);
+	}
+
+	void finish_benchmark_frame() {
+		const std::string name = benchmark_->config().name;
+
+		if (!benchmark_->record({ 1000.0f * time_.delta_time, last_fragment_invocations_, stats_.visible_total, stats_.cull })) return;
+
+		std::cout << "benchmark: " << name << " done" << std::endl;
+
+		if (benchmark_->running()) return;
+
+		benchmark_->write_csv("benchmark.csv");
+		std::cout << "benchmark results written to benchmark.csv" << std::endl;
+
+		benchmark_.reset();
+		path_ = settings_before_benchmark_.path;
+		sort_blades_ = settings_before_benchmark_.sort;
+
+		if (quit_after_benchmark_) close_window();
+	}
+
+	// GRASS_PRESENT, or P. the limiter only holds vsync to the refresh rate, the other
+	// policies are paced by the presentation engine or not at all
+	void apply_present_policy() {
+		refresh_duration_ = GPU_.refresh_duration();
+
+		if (GPU_.present_policy_ != present_policy::vsync) limiter_.set_interval(frame_limiter::clock::duration::zero());
+		else if (tools::params::FRAME_LIMIT_HZ > 0) limiter_.set_interval(std::chrono::nanoseconds(1'000'000'000 / tools::params::FRAME_LIMIT_HZ));
+		else limiter_.set_interval(refresh_duration_);
+
+		std::cout << "presenting " << present_policy_name(GPU_.present_policy_) << ", " << vk::to_string(GPU_.present_mode_) << std::endl;
+	}
+
+	void cycle_present_policy() {
+		GPU_.present_policy_ = static_cast<present_policy>((static_cast<int>(GPU_.present_policy_) + 1) % 4);
+		swapchain_stale_ = true;
+	}
+
+	// input to photon. with display timing from the reported present times, otherwise
+	// from the timeline values of finished frames plus a refresh the image may still wait for
+	void sample_frame_latency() {
+		const auto now = std::chrono::steady_clock::now();
+
+		if (GPU_.display_timing_) {
+			// actualPresentTime is CLOCK_MONOTONIC, the clock steady_clock reads on Linux
+			for (const auto& timing : GPU_.past_presentation_timings()) {
+				const auto input = present_input_times_[timing.presentID % present_input_times_.size()];
+				const auto shown = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(timing.actualPresentTime));
+
+				if (shown > input) latency_.add(shown - input);
+			}
+		}
+		else {
+			const auto scanout = GPU_.present_mode_ == vk::PresentModeKHR::eImmediate ? std::chrono::nanoseconds(0) : refresh_duration_;
+
+			for (uint32_t frame = 0; frame < MAX_FRAMES_IN_FLIGHT; ++frame) {
+				if (!input_pending_[frame] || !GPU_.timeline_reached(GPU_.graphics_timeline_, frame_values_[frame])) continue;
+
+				latency_.add(now - input_times_[frame] + scanout);
+				input_pending_[frame] = false;
+			}
+		}
+
+		if (!latency_report_ || now - last_latency_report_ < std::chrono::duration<float>(tools::params::LATENCY_REPORT_SECONDS)) return;
+
+		last_latency_report_ = now;
+
+		std::cout << "input to photon " << (GPU_.display_timing_ ? "" : "(estimated) ") << latency_.average_ms() << " ms, max " << latency_.max_ms() << " ms" << std::endl;
 	}
 
 	void draw_frame() {
-		GPU_.compute_queue_.waitIdle();
+		GPU_.update_shader_reload();
+
+		// whatever blocks, the frame slot's previous frame and the acquire, comes before the input is read
+		GPU_.wait_timeline(GPU_.graphics_timeline_, frame_values_[current_frame]);
+
+		sample_frame_latency();
+
+		// the secondary buffers of this frame slot are done with as well
+		recorder_.begin_frame(current_frame);
 
-		GPU_.compute_command_buffer_.reset();
+		read_pipeline_statistics();
+		read_frame_stats();
+		update_render_scale();
+
+		uint32_t image_index;
+
+		try {
+			auto acquire_image_result = GPU_.logical_device_.acquireNextImageKHR(GPU_.swapchain_, UINT64_MAX, GPU_.image_available_semaphores[current_frame]);
+			image_index = acquire_image_result.value;
+
+			// still presentable, rebuilt after this frame
+			if (acquire_image_result.result == vk::Result::eSuboptimalKHR) swapchain_stale_ = true;
+		}
+		catch (const vk::OutOfDateKHRError&) {
+			// nothing was submitted for this frame slot, its value stays the reached one
+			swapchain_stale_ = true;
+			return;
+		}
+
+		// the tuner and the fp16 report read what the last compute submission wrote,
+		// nothing else waits for it on the CPU
+		if (tuner_ || fp16_report_) GPU_.wait_timeline(GPU_.compute_timeline_, GPU_.compute_timeline_value_);
+
+		update_workgroup_tuning();
+		update_fp16_report();
+
+		// the camera as late as it gets, the compute and the graphics work both see it
+		take_input();
+		input_times_[current_frame] = std::chrono::steady_clock::now();
+
+		update_visibility();
+
+		auto& compute_command_buffer = GPU_.compute_command_buffers_[current_frame];
+		compute_command_buffer.reset();
 		
 		record_compute_command_buffer();
 
+		// the cull pass rewrites the buffers the previous frame's draws read, it waits for them on the GPU
+		const uint64_t previous_graphics_value = GPU_.graphics_timeline_value_;
+		const uint64_t compute_value = ++GPU_.compute_timeline_value_;
+
+		const vk::PipelineStageFlags compute_wait_stage = vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eComputeShader;
+
+		vk::TimelineSemaphoreSubmitInfo compute_timeline_info{};
+		compute_timeline_info.waitSemaphoreValueCount = 1;
+		compute_timeline_info.pWaitSemaphoreValues = &previous_graphics_value;
+		compute_timeline_info.signalSemaphoreValueCount = 1;
+		compute_timeline_info.pSignalSemaphoreValues = &compute_value;
+
 		vk::SubmitInfo compute_submit_info{};
+		compute_submit_info.pNext = &compute_timeline_info;
+		compute_submit_info.waitSemaphoreCount = 1;
+		compute_submit_info.pWaitSemaphores = &GPU_.graphics_timeline_;
+		compute_submit_info.pWaitDstStageMask = &compute_wait_stage;
 		compute_submit_info.commandBufferCount = 1;
-		compute_submit_info.pCommandBuffers = &GPU_.compute_command_buffer_;
+		compute_submit_info.pCommandBuffers = &compute_command_buffer;
+		compute_submit_info.signalSemaphoreCount = 1;
+		compute_submit_info.pSignalSemaphores = &GPU_.compute_timeline_;
 
 		GPU_.compute_queue_.submit(compute_submit_info);
-
-		GPU_.logical_device_.waitForFences(GPU_.in_flight_fences[current_frame], true, UINT64_MAX);
-		GPU_.logical_device_.resetFences(GPU_.in_flight_fences[current_frame]);
-
-		auto acquire_image_result = GPU_.logical_device_.acquireNextImageKHR(GPU_.swapchain_, UINT64_MAX, GPU_.image_available_semaphores[current_frame]);
-		auto image_index = acquire_image_result.value;
+		stats_values_[current_frame] = compute_value;
 
 		GPU_.command_buffers[current_frame].reset();
 		record_command_buffer(GPU_.command_buffers[current_frame], image_index);
 
+		// the swapchain image for the upscale, this frame's compute results for every draw
 		vk::Semaphore wait_semaphores[] = {
-			GPU_.image_available_semaphores[current_frame]
+			GPU_.image_available_semaphores[current_frame],
+			GPU_.compute_timeline_
 		};
 		vk::PipelineStageFlags wait_stages[] = {
-			vk::PipelineStageFlagBits::eColorAttachmentOutput
+			vk::PipelineStageFlagBits::eColorAttachmentOutput,
+			vk::PipelineStageFlagBits::eDrawIndirect
 		};
+		const uint64_t wait_values[] = { 0, compute_value }; // the binary semaphore's is ignored
 
-		vk::PipelineStageFlags compute_wait_stages[] = {
-			vk::PipelineStageFlagBits::eComputeShader
+		vk::Semaphore signal_semaphores[] = {
+			GPU_.render_finished_semaphores[current_frame],
+			GPU_.graphics_timeline_
 		};
+		const uint64_t frame_value = ++GPU_.graphics_timeline_value_;
+		const uint64_t signal_values[] = { 0, frame_value };
 
-		vk::CommandBuffer buffers_to_submit[] = { GPU_.command_buffers[current_frame], GPU_.compute_command_buffer_ };
+		vk::TimelineSemaphoreSubmitInfo timeline_info{};
+		timeline_info.waitSemaphoreValueCount = 2;
+		timeline_info.pWaitSemaphoreValues = wait_values;
+		timeline_info.signalSemaphoreValueCount = 2;
+		timeline_info.pSignalSemaphoreValues = signal_values;
 
 		vk::SubmitInfo submit_info{};
-		submit_info.waitSemaphoreCount = 1;
+		submit_info.pNext = &timeline_info;
+		submit_info.waitSemaphoreCount = 2;
 		submit_info.pWaitSemaphores = wait_semaphores;
 		submit_info.pWaitDstStageMask = wait_stages;
 		submit_info.commandBufferCount = 1;
 		submit_info.pCommandBuffers = &GPU_.command_buffers[current_frame];
-
-		vk::Semaphore signal_semaphores[] = {
-			GPU_.render_finished_semaphores[current_frame]
-		};
 		submit_info.pSignalSemaphores = signal_semaphores;
-		submit_info.signalSemaphoreCount = 1;
+		submit_info.signalSemaphoreCount = 2;
 
-		GPU_.graphics_queue_.submit(submit_info, GPU_.in_flight_fences[current_frame]);
+		GPU_.graphics_queue_.submit(submit_info);
+		frame_values_[current_frame] = frame_value;
 
 		vk::PresentInfoKHR present_info{};
 		present_info.waitSemaphoreCount = 1;
@@ -283,34 +1337,161 @@ private:
 		present_info.swapchainCount = 1;
 		present_info.pImageIndices = &image_index;
 
-		auto present_result = GPU_.present_queue_.presentKHR(present_info); 
-		/*if (present_result == vk::Result::eErrorOutOfDateKHR) {
-			recreate_swapchain();
-			return;
-		}*/
+		// the ID comes back with the actual present time, see sample_frame_latency
+		vk::PresentTimeGOOGLE present_time{ ++present_id_, 0 };
+		vk::PresentTimesInfoGOOGLE present_times{ 1, &present_time };
+
+		if (GPU_.display_timing_) {
+			present_info.pNext = &present_times;
+			present_input_times_[present_id_ % present_input_times_.size()] = input_times_[current_frame];
+		}
+		else input_pending_[current_frame] = true;
+
+		try {
+			if (GPU_.present_queue_.presentKHR(present_info) == vk::Result::eSuboptimalKHR) swapchain_stale_ = true;
+		}
+		catch (const vk::OutOfDateKHRError&) {
+			swapchain_stale_ = true;
+		}
 
 		++current_frame %= MAX_FRAMES_IN_FLIGHT;
 	}
 
 private:
-	uint32_t current_frame;
+	uint32_t current_frame = 0;
+
+	// first, so that time to first frame covers everything the members do
+	std::chrono::steady_clock::time_point created_ = std::chrono::steady_clock::now();
+	bool first_frame_drawn_ = false;
+
+	// the main thread that creates it and the render thread, see render
+	job_system jobs_{ tools::params::JOB_WORKERS > 0 ? tools::params::JOB_WORKERS : std::max(std::thread::hardware_concurrency(), 2u) - 1, 2 };
 
-	std::vector<vertex> vertices = {
-		{{-0.5f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 0.0f}},
-		{{0.5f, -0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f}},
-		{{0.5f, 0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f}},
-		{{-0.5f, 0.5f, 0.0f}, {1.0f, 1.0f, 1.0f}, {0.0f, 1.0f}}
+	terrain terrain_{
+		tools::params::TERRAIN_DIM, tools::params::TERRAIN_CHUNK_DIM,
+		tools::params::TERRAIN_CHUNK_RESOLUTION, tools::params::TERRAIN_SKIRT_DEPTH
 	};
 
-	std::vector<uint32_t> indices = {
-		0, 1, 2, 2, 3, 0
+	std::vector<terrain::chunk_draw> chunk_draws_;
+	std::vector<bool> visible_chunks_ = std::vector<bool>(terrain_.chunks_per_row() * terrain_.chunks_per_row(), false);
+	std::vector<bool> visible_grass_tiles_ = std::vector<bool>(terrain_.chunks_per_row() * terrain_.chunks_per_row(), false);
+
+	// the grass tiles are the terrain chunks
+	tile_streamer streamer_{
+		tools::params::TERRAIN_DIM, tools::params::TERRAIN_CHUNK_DIM, tools::params::STREAM_POOL_SLOTS,
+		tools::params::BLADES_PER_TILE, tools::params::STREAM_WORKERS
 	};
 
-	std::vector<blade> blades = grass::generate_terrain(4000);
+	device_context GPU_{ terrain_.vertices(), terrain_.indices(), tools::params::STREAM_POOL_SLOTS * tools::params::BLADES_PER_TILE, jobs_ };
 
-	dimensional plane{ vertices, indices };
+	// GRASS_JOB_TRACE=1 writes the task spans of the whole run to job_trace.json
+	std::optional<job_trace> job_trace_;
 
-	device_context GPU_{ plane.vertices, plane.indices, blades };
+	// declared after GPU_, the pools go before the device
+	parallel_recorder recorder_{
+		GPU_.logical_device_,
+		static_cast<uint32_t>(findQueueFamilies(GPU_.physical_device_, GPU_.surface_).graphics_family),
+		MAX_FRAMES_IN_FLIGHT,
+		jobs_
+	};
 
 	time_data_t time_;
+	std::chrono::high_resolution_clock::time_point last_frame_time_ = std::chrono::high_resolution_clock::now();
+
+	// main thread to render thread, see run
+	snapshot_channel<input_snapshot> input_;
+	spsc_queue<int, 64> keys_;
+	vk::Extent2D framebuffer_; // main thread's, from the size callback
+	std::atomic<bool> stop_rendering_ = false;
+	std::exception_ptr render_error_;
+
+	// render thread's, from input_ once a frame
+	glm::mat4 view_{ 1.0f };
+	glm::vec3 eye_{ 0.0f };
+	camera benchmark_camera_;
+
+	// set on resize or when the swapchain no longer matches the surface, see device_context::recreate_swapchain
+	bool swapchain_stale_ = false;
+
+	frame_limiter limiter_; // vsync only, see apply_present_policy
+	std::chrono::nanoseconds refresh_duration_{ 0 };
+
+	// when each frame slot read its input, and whether its latency is still to be taken
+	std::array<std::chrono::steady_clock::time_point, MAX_FRAMES_IN_FLIGHT> input_times_{};
+	std::array<bool, MAX_FRAMES_IN_FLIGHT> input_pending_{};
+
+	// by present ID, for the display timing reports
+	uint32_t present_id_ = 0;
+	std::array<std::chrono::steady_clock::time_point, 16> present_input_times_{};
+
+	// the graphics timeline value of each frame slot's last frame, see draw_frame
+	std::array<uint64_t, MAX_FRAMES_IN_FLIGHT> frame_values_{};
+
+	// the compute timeline value each frame slot's readback block waits for, 0 once it is read,
+	// and the lods it was recorded with drawn as strips. see record_stats_readback
+	std::array<uint64_t, MAX_FRAMES_IN_FLIGHT> stats_values_{};
+	std::array<uint32_t, MAX_FRAMES_IN_FLIGHT> stats_strip_lods_{};
+	frame_stats stats_; // render thread's
+	snapshot_channel<frame_stats> stats_channel_;
+	bool stats_report_ = std::getenv("GRASS_STATS_REPORT") != nullptr;
+	std::chrono::steady_clock::time_point last_stats_report_{};
+
+	latency_tracker latency_;
+	bool latency_report_ = std::getenv("GRASS_LATENCY_REPORT") != nullptr;
+	std::chrono::steady_clock::time_point last_latency_report_{};
+	wind_data_t wind_;
+	glm::vec4 wake_sphere_{ 0.0f };
+
+	glm::mat4 previous_view_projection_{ 1.0f };
+
+	// the share of the swapchain extent the scene is drawn at, R switches it off and on
+	resolution_controller resolution_{ tools::params::SCENE_GPU_BUDGET_MS, tools::params::MIN_RENDER_SCALE };
+	bool dynamic_resolution_ = tools::params::DYNAMIC_RESOLUTION;
+	float render_scale_ = 1.0f;
+	vk::Extent2D render_extent_{ tools::params::WIDTH, tools::params::HEIGHT };
+
+	// the scene pass timestamps of each frame slot, and the scale it was recorded at
+	std::array<bool, MAX_FRAMES_IN_FLIGHT> scene_timed_{};
+	std::array<float, MAX_FRAMES_IN_FLIGHT> scene_scales_{};
+	double last_scene_ms_ = 0.0;
+
+	bool sort_blades_ = true;
+	grass_path path_ = grass_path::tessellation;
+
+	// the first run on a device, see workgroup_tuner.hpp
+	std::optional<workgroup_tuner> tuner_;
+	std::optional<size_t> timed_candidate_; // the one the pending compute submission runs
+	uint32_t awake_groups_size_ = 0; // the physics workgroup size the awake list's group count is for
+
+	enum class fp16_report_phase {
+		waiting,	// for the workgroup tuning to finish
+		copying,	// the reference pool from the live one, this frame
+		running,	// both physics kernels every frame
+		read_back	// both pools, compared next frame
+	};
+
+	// GRASS_FP16_REPORT=1, see update_fp16_report
+	struct fp16_report {
+		fp16_report_phase phase = fp16_report_phase::waiting;
+		float simulated_seconds = 0.0f;
+	};
+
+	std::optional<fp16_report> fp16_report_;
+
+	std::optional<benchmark> benchmark_;
+	struct {
+		grass_path path = grass_path::tessellation;
+		bool sort = true;
+	} settings_before_benchmark_;
+	bool quit_after_benchmark_ = false;
+
+	// moving averages of the grass draw's fragment shader invocations
+	struct {
+		double sorted = 0.0;
+		double unsorted = 0.0;
+	} fragment_invocations_;
+
+	std::array<bool, MAX_FRAMES_IN_FLIGHT> query_sorted_{};
+	std::array<bool, MAX_FRAMES_IN_FLIGHT> query_recorded_{};
+	uint64_t last_fragment_invocations_ = 0;
 };
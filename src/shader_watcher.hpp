@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <unordered_map>
+#include <chrono>
+#include <string_view>
+
+// polls the loose SPIR-V files in the working directory, and the GLSL they are
+// compiled from next to them, for changes. only reports, compiling and rebuilding
+// is up to the caller. a file that appears counts as changed, one that goes away does not.
+// a change is only reported once the file has stayed the same for a whole interval,
+// so a compiler still writing it is not caught halfway
+class shader_watcher {
+public:
+	struct changes {
+		std::vector<std::string> binaries; // .spv files to rebuild the pipelines of
+		std::vector<std::string> sources; // GLSL to compile, its .spv is reported once written
+	};
+
+	shader_watcher(std::vector<std::string> binaries, std::chrono::milliseconds interval)
+		: binaries_(std::move(binaries)), interval_(interval)
+	{
+		// whatever is there now is what the pipelines were built from
+		for (const auto& binary : binaries_) {
+			seen_[binary] = write_time(binary);
+			seen_[source_of(binary)] = write_time(source_of(binary));
+		}
+	}
+
+public:
+	// at most once an interval, empty in between
+	changes poll() {
+		changes found;
+
+		const auto now = std::chrono::steady_clock::now();
+		if (now - last_poll_ < interval_) return found;
+
+		last_poll_ = now;
+
+		for (const auto& binary : binaries_) {
+			if (changed(binary)) found.binaries.push_back(binary);
+
+			// the .spv it produces shows up as changed on a later poll
+			if (changed(source_of(binary))) found.sources.push_back(source_of(binary));
+		}
+
+		return found;
+	}
+
+	// grass.comp.spv is compiled from grass.comp
+	static std::string source_of(const std::string& binary) {
+		return binary.substr(0, binary.size() - std::string_view(".spv").size());
+	}
+
+private:
+	static std::filesystem::file_time_type write_time(const std::string& path) {
+		std::error_code error;
+		const auto time = std::filesystem::last_write_time(path, error);
+
+		return error ? std::filesystem::file_time_type::min() : time;
+	}
+
+	bool changed(const std::string& path) {
+		const auto time = write_time(path);
+		auto& seen = seen_[path];
+		auto& settling = settling_[path];
+
+		if (time <= seen) return false;
+
+		if (time != settling) {
+			settling = time;
+			return false;
+		}
+
+		seen = time;
+		return true;
+	}
+
+private:
+	std::vector<std::string> binaries_;
+	std::unordered_map<std::string, std::filesystem::file_time_type> seen_; // last reported
+	std::unordered_map<std::string, std::filesystem::file_time_type> settling_; // seen on the previous poll
+
+	std::chrono::milliseconds interval_;
+	std::chrono::steady_clock::time_point last_poll_{};
+};
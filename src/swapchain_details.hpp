@@ -1,5 +1,8 @@
 #pragma once
 #include "config.hpp"
+#include "frame_pacing.hpp"
+
+#include <algorithm>
 
 namespace vk_tools {
 	struct swapchain_support_details {
@@ -27,26 +30,29 @@ namespace vk_tools {
 		return available_formats.front();
 	}
 
-	auto choose_present_mode(const std::vector<vk::PresentModeKHR> &available_modes) {
-		for (const auto& mode : available_modes)
-			//if (mode == vk::PresentModeKHR::eFifo) return mode;
-			if (mode == vk::PresentModeKHR::eImmediate) return mode;
-		return available_modes.front();
+	// the policy's modes in order of preference, fifo is always there to fall back to
+	auto choose_present_mode(const std::vector<vk::PresentModeKHR> &available_modes, present_policy policy) {
+		std::vector<vk::PresentModeKHR> preferred;
+
+		switch (policy) {
+		case present_policy::low_latency: preferred = { vk::PresentModeKHR::eMailbox, vk::PresentModeKHR::eImmediate }; break;
+		case present_policy::relaxed: preferred = { vk::PresentModeKHR::eFifoRelaxed }; break;
+		case present_policy::uncapped: preferred = { vk::PresentModeKHR::eImmediate, vk::PresentModeKHR::eMailbox }; break;
+		case present_policy::vsync: break;
+		}
+
+		for (const auto& mode : preferred)
+			if (std::find(available_modes.begin(), available_modes.end(), mode) != available_modes.end()) return mode;
+
+		return vk::PresentModeKHR::eFifo;
 	}
 
-	auto choose_swap_extent(const vk::SurfaceCapabilitiesKHR &capabilities, GLFWwindow* window) {
+	// framebuffer is the window's framebuffer size, GLFW only gives it out on the main thread
+	auto choose_swap_extent(const vk::SurfaceCapabilitiesKHR &capabilities, vk::Extent2D framebuffer) {
 		if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max())
 			return capabilities.currentExtent;
 
-		int width;
-		int height;
-
-		glfwGetFramebufferSize(window, &width, &height);
-
-		vk::Extent2D actual_extent = {
-			static_cast<uint32_t>(width),
-			static_cast<uint32_t>(height),
-		};
+		vk::Extent2D actual_extent = framebuffer;
 
 		actual_extent.width = 
 			std::clamp(
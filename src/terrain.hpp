@@ -0,0 +1,239 @@
+#pragma once
+#include "config.hpp"
+#include "vertex.hpp"
+#include "blade.hpp"
+
+#include <vector>
+#include <array>
+#include <cmath>
+
+// a square heightfield cut into chunks along the grass tile grid, so that
+// chunk (row, column) covers exactly grass card tile (row, column).
+// every chunk has the same topology: one index range per lod serves all
+// of them and a chunk is drawn with its own vertex offset
+class terrain {
+public:
+	static constexpr uint32_t lod_count = 4; // 1, 2, 4 and 8 grid cells per quad
+
+	struct index_range {
+		uint32_t first_index;
+		uint32_t index_count;
+	};
+
+	struct chunk_draw {
+		uint32_t chunk;
+		uint32_t lod;
+	};
+
+	terrain(float world_dim, float chunk_dim, uint32_t chunk_resolution, float skirt_depth)
+		: world_dim_(world_dim), chunk_dim_(chunk_dim), resolution_(chunk_resolution), skirt_depth_(skirt_depth)
+	{
+		chunks_per_row_ = static_cast<uint32_t>(world_dim / chunk_dim);
+
+		generate_vertices();
+		generate_indices();
+	}
+
+public:
+	// the same everywhere, the grass and the cards are placed with it too
+	static float height(float x, float z) {
+		return 2.0f * std::sin(0.08f * x) * std::cos(0.06f * z)
+			+ 1.0f * std::sin(0.21f * x + 0.17f * z)
+			+ 0.5f * std::cos(0.37f * x - 0.29f * z);
+	}
+
+	// moves blades generated on the y = 0 plane onto the ground, v1 and v2 go along with v0
+	static std::vector<blade> place(std::vector<blade> blades) {
+		for (auto& b : blades)
+			b.v0.y += height(b.v0.x, b.v0.z);
+
+		return blades;
+	}
+
+	const std::vector<vertex>& vertices() const {
+		return vertices_;
+	}
+
+	const std::vector<uint32_t>& indices() const {
+		return indices_;
+	}
+
+	uint32_t chunks_per_row() const {
+		return chunks_per_row_;
+	}
+
+	uint32_t vertices_per_chunk() const {
+		const uint32_t side = resolution_ + 1;
+		return side * side + 4 * side;
+	}
+
+	index_range lod(uint32_t level) const {
+		return lods_[level];
+	}
+
+	// chunks within view_distance of the eye that touch the frustum, the
+	// only ones iterated at all, so the cost does not grow with the world.
+	// margin grows the bounds for whatever stands on the ground, the grass
+	std::vector<chunk_draw> visible_chunks(const std::array<glm::vec4, 6>& frustum, const glm::vec3& eye, float view_distance, float lod_distance, float margin = 0.0f) const {
+		std::vector<chunk_draw> draws;
+
+		const float origin = -0.5f * world_dim_;
+
+		const auto first_cell = [&](float p) {
+			return static_cast<uint32_t>(glm::clamp(std::floor((p - view_distance - origin) / chunk_dim_), 0.0f, float(chunks_per_row_)));
+		};
+		const auto last_cell = [&](float p) {
+			return static_cast<uint32_t>(glm::clamp(std::ceil((p + view_distance - origin) / chunk_dim_), 0.0f, float(chunks_per_row_)));
+		};
+
+		for (uint32_t row = first_cell(eye.z); row < last_cell(eye.z); ++row) {
+			for (uint32_t column = first_cell(eye.x); column < last_cell(eye.x); ++column) {
+				const uint32_t chunk = row * chunks_per_row_ + column;
+
+				const glm::vec3 bounds_min{ origin + column * chunk_dim_ - margin, chunk_heights_[chunk].x - skirt_depth_, origin + row * chunk_dim_ - margin };
+				const glm::vec3 bounds_max{ bounds_min.x + chunk_dim_ + 2.0f * margin, chunk_heights_[chunk].y + margin, bounds_min.z + chunk_dim_ + 2.0f * margin };
+
+				const glm::vec2 center = 0.5f * (glm::vec2(bounds_min.x, bounds_min.z) + glm::vec2(bounds_max.x, bounds_max.z));
+				const float distance = glm::length(center - glm::vec2(eye.x, eye.z));
+
+				if (distance > view_distance + chunk_dim_ || !in_frustum(frustum, bounds_min, bounds_max)) continue;
+
+				const float steps = std::floor(std::log2(std::max(distance / lod_distance, 1.0f)));
+				draws.push_back({ chunk, std::min(static_cast<uint32_t>(steps), lod_count - 1) });
+			}
+		}
+
+		return draws;
+	}
+
+private:
+	// the positive vertex of the box against every plane
+	static bool in_frustum(const std::array<glm::vec4, 6>& frustum, const glm::vec3& bounds_min, const glm::vec3& bounds_max) {
+		for (const auto& plane : frustum) {
+			const glm::vec3 positive{
+				plane.x >= 0.0f ? bounds_max.x : bounds_min.x,
+				plane.y >= 0.0f ? bounds_max.y : bounds_min.y,
+				plane.z >= 0.0f ? bounds_max.z : bounds_min.z
+			};
+
+			if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f) return false;
+		}
+
+		return true;
+	}
+
+	// the grid of a chunk row by row, then its four borders once more, skirt_depth lower
+	void generate_vertices() {
+		const uint32_t side = resolution_ + 1;
+		const float cell = chunk_dim_ / resolution_;
+		const float origin = -0.5f * world_dim_;
+
+		vertices_.reserve(chunks_per_row_ * chunks_per_row_ * vertices_per_chunk());
+		chunk_heights_.reserve(chunks_per_row_ * chunks_per_row_);
+
+		auto make_vertex = [&](float x, float z, float y) {
+			// finite differences for a bit of shading, the texture repeats every chunk
+			const float e = 0.5f * cell;
+			const glm::vec3 normal = glm::normalize(glm::vec3(height(x - e, z) - height(x + e, z), 2.0f * e, height(x, z - e) - height(x, z + e)));
+			const float shade = 0.4f + 0.6f * glm::max(normal.y, 0.0f);
+
+			return vertex{ { x, y, z }, glm::vec3(shade), { x / chunk_dim_ * 0.5f, z / chunk_dim_ * 0.5f } };
+		};
+
+		for (uint32_t row = 0; row < chunks_per_row_; ++row) {
+			for (uint32_t column = 0; column < chunks_per_row_; ++column) {
+				const float chunk_x = origin + column * chunk_dim_;
+				const float chunk_z = origin + row * chunk_dim_;
+
+				glm::vec2 heights{ std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest() };
+
+				for (uint32_t j = 0; j < side; ++j) {
+					for (uint32_t i = 0; i < side; ++i) {
+						const float x = chunk_x + i * cell;
+						const float z = chunk_z + j * cell;
+						const float y = height(x, z);
+
+						heights = { std::min(heights.x, y), std::max(heights.y, y) };
+						vertices_.push_back(make_vertex(x, z, y));
+					}
+				}
+
+				for (uint32_t edge = 0; edge < 4; ++edge) {
+					for (uint32_t k = 0; k < side; ++k) {
+						const auto [i, j] = border_cell(edge, k);
+
+						const float x = chunk_x + i * cell;
+						const float z = chunk_z + j * cell;
+
+						vertices_.push_back(make_vertex(x, z, height(x, z) - skirt_depth_));
+					}
+				}
+
+				chunk_heights_.push_back(heights);
+			}
+		}
+	}
+
+	// grid cell of the k-th vertex along an edge: bottom, right, top, left
+	std::pair<uint32_t, uint32_t> border_cell(uint32_t edge, uint32_t k) const {
+		switch (edge) {
+		case 0:		return { k, 0 };
+		case 1:		return { resolution_, k };
+		case 2:		return { k, resolution_ };
+		default:	return { 0, k };
+		}
+	}
+
+	void generate_indices() {
+		const uint32_t side = resolution_ + 1;
+		const uint32_t skirt_base = side * side;
+
+		for (uint32_t level = 0; level < lod_count; ++level) {
+			const uint32_t step = 1u << level;
+			lods_[level].first_index = static_cast<uint32_t>(indices_.size());
+
+			// counter-clockwise seen from above
+			for (uint32_t j = 0; j + step <= resolution_; j += step) {
+				for (uint32_t i = 0; i + step <= resolution_; i += step) {
+					const uint32_t a = j * side + i;
+					const uint32_t b = (j + step) * side + i;
+					const uint32_t c = (j + step) * side + i + step;
+					const uint32_t d = j * side + i + step;
+
+					indices_.insert(indices_.end(), { a, b, c, a, c, d });
+				}
+			}
+
+			// the skirts hang from the border vertices of this lod only and cover the
+			// cracks towards coarser neighbours, both faces since they are seen from either side
+			for (uint32_t edge = 0; edge < 4; ++edge) {
+				for (uint32_t k = 0; k + step <= resolution_; k += step) {
+					const auto [i0, j0] = border_cell(edge, k);
+					const auto [i1, j1] = border_cell(edge, k + step);
+
+					const uint32_t top0 = j0 * side + i0;
+					const uint32_t top1 = j1 * side + i1;
+					const uint32_t bottom0 = skirt_base + edge * side + k;
+					const uint32_t bottom1 = skirt_base + edge * side + k + step;
+
+					indices_.insert(indices_.end(), { top0, bottom0, bottom1, top0, bottom1, top1 });
+					indices_.insert(indices_.end(), { top0, bottom1, bottom0, top0, top1, bottom1 });
+				}
+			}
+
+			lods_[level].index_count = static_cast<uint32_t>(indices_.size()) - lods_[level].first_index;
+		}
+	}
+
+private:
+	float world_dim_;
+	float chunk_dim_;
+	uint32_t resolution_;
+	float skirt_depth_;
+	uint32_t chunks_per_row_ = 0;
+
+	std::vector<vertex> vertices_;
+	std::vector<uint32_t> indices_;
+	std::vector<glm::vec2> chunk_heights_; // min and max of every chunk
+	std::array<index_range, lod_count> lods_{};
+};
@@ -0,0 +1,241 @@
+#pragma once
+#include "config.hpp"
+#include "blade.hpp"
+#include "terrain.hpp"
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <limits>
+
+// keeps the grass of the tiles around the camera in a fixed pool of slots,
+// blades_per_tile blades each. tiles are generated on worker threads, the
+// render loop only picks up finished ones, a few per frame, and once the
+// pool is full the slot of the least recently needed tile is reused.
+// the table mirrors the slots for the cull pass
+class tile_streamer {
+public:
+	struct upload {
+		uint32_t slot;
+		std::vector<blade> blades;
+	};
+
+	tile_streamer(float world_dim, float tile_dim, uint32_t slots, uint32_t blades_per_tile, uint32_t workers)
+		: world_dim_(world_dim), tile_dim_(tile_dim), blades_per_tile_(blades_per_tile),
+		tiles_per_row_(static_cast<uint32_t>(world_dim / tile_dim)), slots_(slots), table_(slots, grass_tile_slot{ 0, 0, 0, 0 })
+	{
+		for (uint32_t i = 0; i < workers; ++i)
+			workers_.emplace_back([this] { work(); });
+	}
+
+	~tile_streamer() {
+		{
+			std::lock_guard lock(mutex_);
+			stopping_ = true;
+		}
+
+		requests_ready_.notify_all();
+
+		for (auto& worker : workers_)
+			worker.join();
+	}
+
+	tile_streamer(const tile_streamer&) = delete;
+	tile_streamer& operator=(const tile_streamer&) = delete;
+
+public:
+	// once per frame: requests the tiles within radius of the eye, nearest first,
+	// and hands out at most max_uploads finished ones along with their slot.
+	// never waits for a worker
+	std::vector<upload> update(const glm::vec3& eye, float radius, uint32_t max_uploads) {
+		++frame_;
+
+		const auto wanted = tiles_in_range(eye, radius);
+
+		std::unordered_set<uint32_t> wanted_set;
+		for (const auto& [distance, tile] : wanted) {
+			wanted_set.insert(tile);
+
+			if (auto it = resident_.find(tile); it != resident_.end())
+				slots_[it->second].last_needed = frame_;
+		}
+
+		{
+			std::lock_guard lock(mutex_);
+
+			for (auto& finished : finished_) {
+				in_flight_.erase(finished.tile);
+				ready_[finished.tile] = std::move(finished.blades);
+			}
+
+			finished_.clear();
+
+			// rebuilt every frame, the workers take the nearest tile from the back
+			// and whatever has gone out of range meanwhile is never generated
+			requests_.clear();
+
+			for (auto it = wanted.rbegin(); it != wanted.rend(); ++it) {
+				const uint32_t tile = it->second;
+
+				if (!resident_.count(tile) && !in_flight_.count(tile) && !ready_.count(tile))
+					requests_.push_back(tile);
+			}
+		}
+
+		requests_ready_.notify_all();
+
+		std::vector<upload> uploads;
+
+		for (const auto& [distance, tile] : wanted) {
+			if (uploads.size() >= max_uploads) break;
+
+			auto ready = ready_.find(tile);
+			if (ready == ready_.end()) continue;
+
+			const uint32_t slot = free_slot();
+			if (slot == no_slot) break;
+
+			if (slots_[slot].tile != no_tile)
+				resident_.erase(slots_[slot].tile);
+
+			slots_[slot] = { tile, frame_ };
+			resident_[tile] = slot;
+			table_[slot] = { tile, static_cast<uint32_t>(ready->second.size()), 0, 0 };
+
+			uploads.push_back({ slot, std::move(ready->second) });
+			ready_.erase(ready);
+		}
+
+		// finished, but out of range before a slot came up
+		std::erase_if(ready_, [&](const auto& entry) { return !wanted_set.count(entry.first); });
+
+		return uploads;
+	}
+
+	// visible is left for the caller to fill in
+	const std::vector<grass_tile_slot>& table() const {
+		return table_;
+	}
+
+	uint32_t tiles_per_row() const {
+		return tiles_per_row_;
+	}
+
+	uint32_t resident_tiles() const {
+		return static_cast<uint32_t>(resident_.size());
+	}
+
+private:
+	static constexpr uint32_t no_tile = std::numeric_limits<uint32_t>::max();
+	static constexpr uint32_t no_slot = std::numeric_limits<uint32_t>::max();
+
+	struct slot_info {
+		uint32_t tile = no_tile;
+		uint64_t last_needed = 0;
+	};
+
+	struct finished_tile {
+		uint32_t tile;
+		std::vector<blade> blades;
+	};
+
+	// tiles whose nearest point is within radius of the eye, by that distance
+	std::vector<std::pair<float, uint32_t>> tiles_in_range(const glm::vec3& eye, float radius) const {
+		std::vector<std::pair<float, uint32_t>> tiles;
+
+		const float origin = -0.5f * world_dim_;
+
+		const auto first_cell = [&](float p) {
+			return static_cast<uint32_t>(glm::clamp(std::floor((p - radius - origin) / tile_dim_), 0.0f, float(tiles_per_row_)));
+		};
+		const auto last_cell = [&](float p) {
+			return static_cast<uint32_t>(glm::clamp(std::ceil((p + radius - origin) / tile_dim_), 0.0f, float(tiles_per_row_)));
+		};
+
+		for (uint32_t row = first_cell(eye.z); row < last_cell(eye.z); ++row) {
+			for (uint32_t column = first_cell(eye.x); column < last_cell(eye.x); ++column) {
+				const glm::vec2 tile_min{ origin + column * tile_dim_, origin + row * tile_dim_ };
+				const glm::vec2 nearest = glm::clamp(glm::vec2(eye.x, eye.z), tile_min, tile_min + tile_dim_);
+				const float distance = glm::length(nearest - glm::vec2(eye.x, eye.z));
+
+				if (distance <= radius) tiles.push_back({ distance, row * tiles_per_row_ + column });
+			}
+		}
+
+		std::sort(tiles.begin(), tiles.end());
+
+		return tiles;
+	}
+
+	// an empty slot first, then the least recently needed one that is not needed this frame
+	uint32_t free_slot() const {
+		uint32_t lru = no_slot;
+
+		for (uint32_t slot = 0; slot < slots_.size(); ++slot) {
+			if (slots_[slot].tile == no_tile) return slot;
+			if (slots_[slot].last_needed == frame_) continue;
+
+			if (lru == no_slot || slots_[slot].last_needed < slots_[lru].last_needed) lru = slot;
+		}
+
+		return lru;
+	}
+
+	std::vector<blade> generate(uint32_t tile) const {
+		const uint32_t row = tile / tiles_per_row_;
+		const uint32_t column = tile % tiles_per_row_;
+
+		const float origin = -0.5f * world_dim_;
+
+		return terrain::place(grass::generate_tile(origin + column * tile_dim_, origin + row * tile_dim_, tile_dim_, blades_per_tile_, tile));
+	}
+
+	void work() {
+		for (;;) {
+			uint32_t tile;
+
+			{
+				std::unique_lock lock(mutex_);
+				requests_ready_.wait(lock, [this] { return stopping_ || !requests_.empty(); });
+
+				if (stopping_) return;
+
+				tile = requests_.back();
+				requests_.pop_back();
+				in_flight_.insert(tile);
+			}
+
+			auto blades = generate(tile);
+
+			std::lock_guard lock(mutex_);
+			finished_.push_back({ tile, std::move(blades) });
+		}
+	}
+
+private:
+	float world_dim_;
+	float tile_dim_;
+	uint32_t blades_per_tile_;
+	uint32_t tiles_per_row_;
+
+	// render loop only
+	std::vector<slot_info> slots_;
+	std::vector<grass_tile_slot> table_;
+	std::unordered_map<uint32_t, uint32_t> resident_; // tile to slot
+	std::unordered_map<uint32_t, std::vector<blade>> ready_; // finished, waiting for a slot
+	uint64_t frame_ = 0;
+
+	// shared with the workers
+	std::mutex mutex_;
+	std::condition_variable requests_ready_;
+	std::vector<uint32_t> requests_;
+	std::unordered_set<uint32_t> in_flight_;
+	std::vector<finished_tile> finished_;
+	bool stopping_ = false;
+
+	std::vector<std::thread> workers_;
+};
@@ -1,10 +1,105 @@
 #pragma once
 #include "config.hpp"
+#include "frame_pacing.hpp"
 
 namespace tools {
 	struct params {
 		static constexpr uint32_t WIDTH = 1800;
 		static constexpr uint32_t HEIGHT = 1350;
+
+		// blade sleeping, see grass_physics.comp. the threshold is no finer
+		// than the half precision v2 is stored in, or blades never settle
+		static constexpr uint32_t REST_FRAMES_TO_SLEEP = 30;
+		static constexpr float REST_THRESHOLD = 0.002f;
+
+		// lod buckets, by the distance to the camera projected on the ground
+		static constexpr float LOD_MID_DISTANCE = 10.0f;
+		static constexpr float LOD_FAR_DISTANCE = 20.0f;
+		static constexpr float NEAR_TESSELLATION_LEVEL = 10.0f;
+		static constexpr float MID_TESSELLATION_LEVEL = 4.0f;
+		static constexpr uint32_t FAR_STRIP_SEGMENTS = 2;
+
+		// the strip path of the near and mid lods matches their tessellation levels
+		static constexpr uint32_t NEAR_STRIP_SEGMENTS = 10;
+		static constexpr uint32_t MID_STRIP_SEGMENTS = 4;
+
+		// far field cards, see grass_card.vert. blades hand over to them
+		// across the band between the two distances
+		static constexpr float CARD_FADE_START = 25.0f;
+		static constexpr float CARD_FADE_END = 35.0f;
+		static constexpr float CARD_FIELD_DIM = 300.0f;
+		static constexpr float CARD_TILE_DIM = 10.0f;
+		static constexpr uint32_t CARDS_PER_TILE = 32;
+		static constexpr float CARD_WIDTH = 3.0f;
+		static constexpr float CARD_HEIGHT = 4.0f;
+		static constexpr uint32_t CARD_TEXTURE_SIZE = 256;
+		static constexpr uint32_t CARD_BLADES = 96; // baked into the card texture
+
+		// the ground, see terrain.hpp. chunks line up with the card tiles
+		static constexpr float TERRAIN_DIM = CARD_FIELD_DIM;
+		static constexpr float TERRAIN_CHUNK_DIM = CARD_TILE_DIM;
+		static constexpr uint32_t TERRAIN_CHUNK_RESOLUTION = 16; // a multiple of 8 for the coarsest lod
+		static constexpr float TERRAIN_SKIRT_DEPTH = 1.0f;
+		static constexpr float TERRAIN_VIEW_DISTANCE = 150.0f;
+		static constexpr float TERRAIN_LOD_DISTANCE = 20.0f; // every further doubling drops a lod
+
+		// streamed grass, see tile_streamer.hpp. a tile is a terrain chunk, and no
+		// blade is drawn past the card band, so nothing further out is resident
+		static constexpr float STREAM_RADIUS = CARD_FADE_END;
+		static constexpr float STREAM_TILE_MARGIN = 5.0f; // blades reach this far out of their chunk's bounds
+		static constexpr uint32_t STREAM_POOL_SLOTS = 80;
+		static constexpr uint32_t BLADES_PER_TILE = 448;
+		static constexpr uint32_t STREAM_UPLOADS_PER_FRAME = 4;
+		static constexpr uint32_t STREAM_WORKERS = 2;
+
+		// blades per shard of the pool, 0 leaves it to maxStorageBufferRange.
+		// anything lower forces several shards, to try them on any device
+		static constexpr uint32_t BLADE_SHARD_LIMIT = 0;
+
+		// threads of the job system besides the main one, see job_system.hpp. 0 uses every core.
+		// the render pass is recorded on them in secondary command buffers, see parallel_recorder.hpp
+		static constexpr uint32_t JOB_WORKERS = 0;
+		static constexpr uint32_t TERRAIN_CHUNKS_PER_JOB = 64;
+		static constexpr uint32_t CARD_ROWS_PER_JOB = 4;
+
+		// workgroup size tuning of grass.comp and grass_physics.comp on the first run on a
+		// device, see workgroup_tuner.hpp. the warmup lets the streamed tiles come in first
+		static constexpr uint32_t WORKGROUP_TUNING_WARMUP_FRAMES = 120;
+		static constexpr uint32_t WORKGROUP_TUNING_FRAMES = 60; // per candidate
+
+		// shader hot reload, GRASS_SHADER_RELOAD=1. changed GLSL next to its .spv is compiled with this.
+		// the instance asks for Vulkan 1.2, which takes SPIR-V up to 1.5, see compile_shaders.py
+		static constexpr uint32_t SHADER_WATCH_INTERVAL_MS = 250;
+		static constexpr const char* SHADER_COMPILER = "glslangValidator -V --target-env vulkan1.2";
+
+		// blade physics and the tessellated curve in fp16 where the device supports it.
+		// GRASS_FP16_REPORT=1 compares it to fp32 after this many simulated seconds
+		static constexpr bool BLADE_FP16 = true;
+		static constexpr float FP16_REPORT_SECONDS = 10.0f;
+
+		// GRASS_PRESENT overrides it, P cycles through the policies. the vsync limiter
+		// runs at FRAME_LIMIT_HZ, or at the monitor's refresh rate if that is 0
+		static constexpr present_policy PRESENT_POLICY = present_policy::low_latency;
+		static constexpr uint32_t FRAME_LIMIT_HZ = 0;
+		static constexpr float LATENCY_REPORT_SECONDS = 5.0f; // GRASS_LATENCY_REPORT=1
+
+		// GRASS_STATS_REPORT=1 prints the counts read back from the cull pass, see frame_stats.hpp.
+		// the per test counters of grass.comp need subgroup ballots, they are in a variant of its own
+		// that is only picked where the device has them. false always picks the one without
+		static constexpr float STATS_REPORT_SECONDS = 5.0f;
+		static constexpr bool CULL_STATS = true;
+
+		// dynamic resolution, see dynamic_resolution.hpp. the scene pass is rendered at a
+		// share of the window that keeps its GPU time near the budget, R switches it off
+		// and on. the upscale sharpens by up to UPSCALE_SHARPNESS at MIN_RENDER_SCALE
+		static constexpr bool DYNAMIC_RESOLUTION = true;
+		static constexpr float SCENE_GPU_BUDGET_MS = 10.0f;
+		static constexpr float MIN_RENDER_SCALE = 0.5f;
+		static constexpr float UPSCALE_SHARPNESS = 0.6f;
+
+		// benchmark runs, see benchmark.hpp
+		static constexpr uint32_t BENCHMARK_WARMUP_FRAMES = 120;
+		static constexpr uint32_t BENCHMARK_FRAMES = 600;
 	};
 	
 	template<typename T>
@@ -0,0 +1,46 @@
+#version 450
+
+// the scene target to the swapchain image. the scene covers only its top left
+// corner, uv_scale of it, which is stretched over the screen bilinearly and then
+// sharpened against its four neighbours. the result is kept within the range of
+// the neighbourhood, so edges do not ring (the idea of contrast adaptive sharpening)
+
+layout(set = 0, binding = 0) uniform sampler2D scene;
+
+layout(push_constant) uniform push_data {
+	vec2 uv_scale;
+	vec2 texel_size;
+	float sharpness; // 0 at the full resolution, the bilinear result as it is
+} push;
+
+layout(location = 0) in vec2 screen_uv;
+
+layout(location = 0) out vec4 out_color;
+
+// past the rendered corner the target holds only the clear color
+vec3 fetch(vec2 uv) {
+	vec2 half_texel = 0.5 * push.texel_size;
+	return texture(scene, clamp(uv, half_texel, push.uv_scale - half_texel)).rgb;
+}
+
+void main() {
+	vec2 uv = screen_uv * push.uv_scale;
+	vec3 center = fetch(uv);
+
+	if (push.sharpness <= 0.0) {
+		out_color = vec4(center, 1.0);
+		return;
+	}
+
+	vec3 north = fetch(uv - vec2(0.0, push.texel_size.y));
+	vec3 south = fetch(uv + vec2(0.0, push.texel_size.y));
+	vec3 west = fetch(uv - vec2(push.texel_size.x, 0.0));
+	vec3 east = fetch(uv + vec2(push.texel_size.x, 0.0));
+
+	vec3 lowest = min(center, min(min(north, south), min(west, east)));
+	vec3 highest = max(center, max(max(north, south), max(west, east)));
+
+	vec3 sharpened = center + push.sharpness * (4.0 * center - north - south - west - east);
+
+	out_color = vec4(clamp(sharpened, lowest, highest), 1.0);
+}
@@ -0,0 +1,151 @@
+#pragma once
+#include "config.hpp"
+
+#include <vector>
+#include <array>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <optional>
+#include <algorithm>
+#include <limits>
+
+// local_size_x of grass.comp and grass_physics.comp
+struct compute_workgroup_sizes {
+	uint32_t cull;
+	uint32_t physics;
+};
+
+// tries every candidate size on both grass kernels for a number of frames, after a warmup
+// that lets the tile streamer fill the pool. the caller times the two dispatches and
+// hands the milliseconds in, each kernel gets the size with the lowest median
+class workgroup_tuner {
+public:
+	workgroup_tuner(std::vector<uint32_t> candidates, uint32_t warmup_frames, uint32_t frames_per_candidate)
+		: candidates_(std::move(candidates)), warmup_frames_(warmup_frames), frames_per_candidate_(frames_per_candidate),
+		samples_(candidates_.size())
+	{}
+
+public:
+	const std::vector<uint32_t>& candidates() const {
+		return candidates_;
+	}
+
+	// index into candidates() of the size to record this frame with, none while warming up
+	std::optional<size_t> candidate() const {
+		if (frame_ < warmup_frames_ || finished()) return std::nullopt;
+
+		return (frame_ - warmup_frames_) / frames_per_candidate_;
+	}
+
+	// once a frame, with the timings of the frame recorded for candidate() before
+	void next_frame() {
+		++frame_;
+	}
+
+	void add_sample(size_t candidate, double cull_milliseconds, double physics_milliseconds) {
+		samples_[candidate].cull.push_back(cull_milliseconds);
+		samples_[candidate].physics.push_back(physics_milliseconds);
+	}
+
+	bool finished() const {
+		return frame_ >= warmup_frames_ + frames_per_candidate_ * candidates_.size();
+	}
+
+	compute_workgroup_sizes winners() const {
+		std::vector<double> cull;
+		std::vector<double> physics;
+
+		for (const auto& candidate : samples_) {
+			cull.push_back(median(candidate.cull));
+			physics.push_back(median(candidate.physics));
+		}
+
+		return {
+			candidates_[std::min_element(cull.begin(), cull.end()) - cull.begin()],
+			candidates_[std::min_element(physics.begin(), physics.end()) - physics.begin()]
+		};
+	}
+
+private:
+	struct candidate_samples {
+		std::vector<double> cull;
+		std::vector<double> physics;
+	};
+
+	// a candidate that got no samples never wins
+	static double median(std::vector<double> values) {
+		if (values.empty()) return std::numeric_limits<double>::max();
+
+		std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+		return values[values.size() / 2];
+	}
+
+private:
+	std::vector<uint32_t> candidates_;
+	uint32_t warmup_frames_;
+	uint32_t frames_per_candidate_;
+
+	std::vector<candidate_samples> samples_;
+	uint64_t frame_ = 0;
+};
+
+// the tuned sizes, a line per device: its UUID in hex, the driver version, then the sizes.
+// another GPU or a driver update tunes anew
+class workgroup_cache {
+public:
+	using device_uuid = std::array<uint8_t, VK_UUID_SIZE>;
+
+	static std::optional<compute_workgroup_sizes> load(const std::string& path, const device_uuid& uuid, uint32_t driver_version) {
+		std::ifstream file(path);
+		std::string line;
+
+		while (std::getline(file, line)) {
+			std::istringstream entry(line);
+
+			std::string entry_uuid;
+			uint32_t entry_driver;
+			compute_workgroup_sizes sizes;
+
+			if (entry >> entry_uuid >> entry_driver >> sizes.cull >> sizes.physics && entry_uuid == hex(uuid) && entry_driver == driver_version)
+				return sizes;
+		}
+
+		return std::nullopt;
+	}
+
+	// replaces the device's line, keeps the others
+	static void store(const std::string& path, const device_uuid& uuid, uint32_t driver_version, const compute_workgroup_sizes& sizes) {
+		std::vector<std::string> lines;
+
+		{
+			std::ifstream file(path);
+			std::string line;
+
+			while (std::getline(file, line))
+				if (!line.starts_with(hex(uuid) + " ")) lines.push_back(line);
+		}
+
+		std::ofstream file(path);
+		if (!file.is_open())
+			throw std::runtime_error("failed to open " + path + "!");
+
+		for (const auto& line : lines)
+			file << line << "\n";
+
+		file << hex(uuid) << " " << driver_version << " " << sizes.cull << " " << sizes.physics << "\n";
+	}
+
+private:
+	static std::string hex(const device_uuid& uuid) {
+		static constexpr char digits[] = "0123456789abcdef";
+
+		std::string text;
+		for (uint8_t byte : uuid) {
+			text += digits[byte >> 4];
+			text += digits[byte & 0xf];
+		}
+
+		return text;
+	}
+};